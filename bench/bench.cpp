@@ -0,0 +1,160 @@
+//
+//  bench.cpp
+//
+//  Headless per-module benchmark. Runs every registered NANO model (or the ones picked with
+//  --module) for a number of seconds of audio and reports ns/sample, cycles/sample and p99.
+//
+//  Usage: nano_bench [--seconds S] [--rate HZ] [--module SLUG]... [--inputs SET] [--outputs SET] [--channels N]
+//  SET is "all", "none" or a comma separated list of port ids, e.g. --outputs 0,4
+//  N is the polyphony of every patched input, 1 to 16
+//
+
+#include "harness.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_TSC 1
+#else
+#define BENCH_HAS_TSC 0
+#endif
+
+// Blank panels have no DSP, don't waste time on them
+static const char *SKIPPED[] = {"BLANK12Hp", "BLANK8Hp", "BLANK6Hp", "BLANK4Hp", "BLANK2Hp"};
+
+struct Options {
+    double seconds = 2.0;
+    float rate = 44100.0f;
+    int channels = 1;
+    std::vector<std::string> modules;
+    bench::PortSet inputs;
+    bench::PortSet outputs;
+};
+
+static uint64_t ticks() {
+#if BENCH_HAS_TSC
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Timer ticks per nanosecond, measured against the steady clock
+static double calibrateTicks() {
+    auto t0 = std::chrono::steady_clock::now();
+    uint64_t c0 = ticks();
+    while (std::chrono::steady_clock::now() - t0 < std::chrono::milliseconds(200)) {
+    }
+    uint64_t c1 = ticks();
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    return (double)(c1 - c0) / ns;
+}
+
+// Cost of an empty ticks() pair, subtracted from every sample
+static uint64_t calibrateOverhead() {
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < 10000; i++) {
+        uint64_t t0 = ticks();
+        uint64_t t1 = ticks();
+        best = std::min(best, t1 - t0);
+    }
+    return best;
+}
+
+static bool parseArgs(int argc, char **argv, Options &opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--seconds" && hasValue) {
+            opt.seconds = atof(argv[++i]);
+        } else if (arg == "--rate" && hasValue) {
+            opt.rate = atof(argv[++i]);
+        } else if (arg == "--module" && hasValue) {
+            opt.modules.push_back(argv[++i]);
+        } else if (arg == "--inputs" && hasValue) {
+            opt.inputs = bench::PortSet::parse(argv[++i]);
+        } else if (arg == "--outputs" && hasValue) {
+            opt.outputs = bench::PortSet::parse(argv[++i]);
+        } else if (arg == "--channels" && hasValue) {
+            opt.channels = std::min(std::max(atoi(argv[++i]), 1), PORT_MAX_CHANNELS);
+        } else {
+            fprintf(stderr, "usage: %s [--seconds S] [--rate HZ] [--module SLUG]... [--inputs all|none|i,j] [--outputs all|none|i,j] [--channels N]\n", argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) return 1;
+
+    bench::setEngineFloatMode();
+    Plugin plugin;
+    init(&plugin);
+
+    if (opt.modules.empty()) {
+        for (Model *model : plugin.models) {
+            bool skip = false;
+            for (const char *s : SKIPPED) skip |= (model->slug == s);
+            if (!skip) opt.modules.push_back(model->slug);
+        }
+    }
+
+    double ticksPerNs = calibrateTicks();
+    uint64_t overhead = calibrateOverhead();
+    int64_t samples = (int64_t)(opt.seconds * opt.rate);
+
+    printf("%.0f Hz, %.2f s per module, inputs=%s outputs=%s channels=%d%s\n", opt.rate, opt.seconds,
+           opt.inputs.describe().c_str(), opt.outputs.describe().c_str(), opt.channels,
+           BENCH_HAS_TSC ? "" : " (no TSC, cycles shown as ns)");
+    printf("%-18s %12s %14s %14s %14s\n", "module", "ns/sample", "cycles/sample", "p99 cycles", "max cycles");
+
+    std::vector<uint32_t> costs(samples);
+    for (const std::string &slug : opt.modules) {
+        bench::Rig rig;
+        if (!rig.build(&plugin, slug, opt.rate)) {
+            fprintf(stderr, "unknown module %s\n", slug.c_str());
+            return 1;
+        }
+        rig.channels = opt.channels;
+        rig.patch(opt.inputs, opt.outputs);
+
+        // Warm up caches, branch predictors and any lazily built state
+        for (int i = 0; i < 4096; i++) rig.step();
+
+        uint64_t total = 0;
+        for (int64_t s = 0; s < samples; s++) {
+            rig.feed();
+            Module::ProcessArgs args = rig.args();
+            uint64_t cost = 0;
+            for (Module *m : rig.row) {
+                if (m != rig.target) {
+                    m->process(args);
+                    continue;
+                }
+                uint64_t t0 = ticks();
+                m->process(args);
+                uint64_t t1 = ticks();
+                cost = (t1 - t0 > overhead) ? (t1 - t0 - overhead) : 0;
+            }
+            rig.flipMessages();
+            rig.frame++;
+            costs[s] = (uint32_t)std::min<uint64_t>(cost, UINT32_MAX);
+            total += cost;
+        }
+
+        std::vector<uint32_t> sorted(costs);
+        size_t p99 = (size_t)(0.99 * (samples - 1));
+        std::nth_element(sorted.begin(), sorted.begin() + p99, sorted.end());
+        uint32_t maxCost = *std::max_element(costs.begin(), costs.end());
+
+        double meanTicks = (double)total / samples;
+        printf("%-18s %12.1f %14.1f %14u %14u\n", slug.c_str(), meanTicks / ticksPerNs, meanTicks, sorted[p99], maxCost);
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+# Headless benchmark and golden-render harnesses, built against the stub engine in bench/stub
+# instead of the Rack SDK. Included by the top level Makefile when a bench goal is requested.
+#
+#   make bench                                         # every module, everything patched
+#   make bench BENCH_ARGS="--module ONA --outputs 0"   # ONA with only the sine out patched
+#   make bench BENCH_ARGS="--module ONA --channels 16" # ONA with 16 voice poly inputs
+#   make golden-check                                  # render this tree and compare with the references
+
+BENCH_DIR := build/bench
+BENCH_BIN := $(BENCH_DIR)/nano_bench
+BENCH_ARGS ?=
+
+# Same code generation flags as the Rack plugin framework so the numbers are comparable
+BENCH_CXXFLAGS := -std=c++11 -O3 -funsafe-math-optimizations -fno-omit-frame-pointer -g
+BENCH_CXXFLAGS += -Wall
+ifneq (,$(filter x86_64% i686%,$(shell $(CXX) -dumpmachine)))
+	BENCH_CXXFLAGS += -march=nehalem
+endif
+BENCH_CXXFLAGS += -Ibench/stub $(FLAGS) $(CXXFLAGS)
+
+BENCH_STUB_SOURCES := bench/stub/context.cpp
+BENCH_OBJECTS := $(patsubst %.cpp,$(BENCH_DIR)/%.o,$(SOURCES) $(BENCH_STUB_SOURCES))
+
+$(BENCH_DIR)/%.o: %.cpp
+	@mkdir -p $(@D)
+	$(CXX) $(BENCH_CXXFLAGS) -MMD -MP -c $< -o $@
+
+$(BENCH_BIN): $(BENCH_OBJECTS) $(BENCH_DIR)/bench/bench.o
+	$(CXX) $^ -o $@ $(LDFLAGS)
+
+.PHONY: bench
+bench: $(BENCH_BIN)
+	./$(BENCH_BIN) $(BENCH_ARGS)
+
+# Golden renders. A reference renderer is the src/ tree of a pinned commit built with the current
+# harness, so the comparison always runs the same stimuli through old and new DSP code. Every
+# module is compared with GOLDEN_REF, the code from before the DSP rewrites. ONA's hard sync at
+# the sub-sample crossing and its subs divided from the main phase changed its output on purpose,
+# so ONA is compared with GOLDEN_ONA_REF, the commit that made those changes. Modes added during
+# the rewrites have no older code to compare with, they are compared with GOLDEN_MODES_REF, the
+# commit that last changed the output of one of them on purpose (hard sync of the oversampled FM).
+GOLDEN_REF ?= fd6497b
+GOLDEN_ONA_REF ?= ed22ee5
+GOLDEN_MODES_REF ?= c19e14c
+GOLDEN_SECONDS ?= 1
+GOLDEN_DIR := build/golden
+GOLDEN_BIN := $(GOLDEN_DIR)/nano_golden
+GOLDEN_HARNESS := bench/golden.cpp bench/harness.hpp $(wildcard bench/stub/*)
+
+$(GOLDEN_BIN): $(BENCH_OBJECTS) $(BENCH_DIR)/bench/golden.o
+	@mkdir -p $(@D)
+	$(CXX) $^ -o $@ $(LDFLAGS)
+
+# Reference renderer $(1) at commit $(2). The patch $(3) is applied to the tree before it is built:
+# the old envelopes read members they never set and list their initializers out of order, the
+# patches give them the initializers the current tree has so the renders are reproducible and the
+# tree builds without warnings.
+define GOLDEN_REFERENCE
+GOLDEN_REF_ROOT_$(1) := $(GOLDEN_DIR)/ref-$(1)-$(2)
+
+$$(GOLDEN_REF_ROOT_$(1))/nano_golden: $(GOLDEN_HARNESS) $(3)
+	rm -rf $$(GOLDEN_REF_ROOT_$(1)) && mkdir -p $$(GOLDEN_REF_ROOT_$(1))
+	git archive $(2) src | tar -x -C $$(GOLDEN_REF_ROOT_$(1))
+	git apply --directory=$$(GOLDEN_REF_ROOT_$(1)) $(3)
+	$$(CXX) $$(BENCH_CXXFLAGS) $$$$(find $$(GOLDEN_REF_ROOT_$(1))/src -name '*.cpp') $$(BENCH_STUB_SOURCES) bench/golden.cpp -o $$@ $$(LDFLAGS)
+
+.PHONY: golden-ref-$(1)
+golden-ref-$(1): $$(GOLDEN_REF_ROOT_$(1))/nano_golden
+	./$$< render $$(GOLDEN_REF_ROOT_$(1))/render --seconds $$(GOLDEN_SECONDS) --reference $(1)
+
+golden-ref: golden-ref-$(1)
+GOLDEN_REF_RENDERS += $$(GOLDEN_REF_ROOT_$(1))/render
+endef
+
+$(eval $(call GOLDEN_REFERENCE,base,$(GOLDEN_REF),bench/golden-ref.patch))
+$(eval $(call GOLDEN_REFERENCE,ona,$(GOLDEN_ONA_REF),bench/golden-ref-ona.patch))
+$(eval $(call GOLDEN_REFERENCE,modes,$(GOLDEN_MODES_REF),bench/golden-ref-ona.patch))
+
+.PHONY: golden golden-ref golden-check
+golden: $(GOLDEN_BIN)
+	./$(GOLDEN_BIN) render $(GOLDEN_DIR)/current --seconds $(GOLDEN_SECONDS)
+
+golden-check: golden golden-ref
+	./$(GOLDEN_BIN) compare $(GOLDEN_REF_RENDERS) $(GOLDEN_DIR)/current
+	./$(GOLDEN_BIN) check
+
+-include $(BENCH_OBJECTS:.o=.d)
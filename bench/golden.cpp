@@ -0,0 +1,1084 @@
+//
+//  golden.cpp
+//
+//  Golden-render regression suite. Drives every NANO model with deterministic inputs and
+//  writes the raw float outputs, then compares a render against reference renders with
+//  per-module tolerances. The references are rendered from pinned commits (see bench.mk),
+//  so any optimized DSP path has to stay within tolerance of the code it replaces.
+//
+//  Usage: nano_golden render DIR [--seconds S] [--rate HZ] [--reference NAME]
+//         nano_golden compare REF_DIR... DIR
+//         nano_golden check
+//
+//  check measures properties of the new modes on this tree alone, see CHECKS.
+//
+//  Each file is DIR/<SLUG>_<scenario>.f32, frame interleaved float32 holding the first
+//  GOLDEN_CHANNELS channels of every output, or as many as a mode render records, preceded
+//  by a small header.
+//
+
+#include "harness.hpp"
+
+#include <cfloat>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#define GOLDEN_CHANNELS 2
+#define GOLDEN_MAGIC 0x4e474f4cu // "NGOL"
+
+static const char *SKIPPED[] = {"BLANK12Hp", "BLANK8Hp", "BLANK6Hp", "BLANK4Hp", "BLANK2Hp"};
+
+// Commits the renders are compared against, built by bench.mk. Every module is held to the code
+// from before the DSP rewrites, except the modules whose output was changed on purpose since,
+// which are held to the commit that last changed it. Modes added since are held to the commit
+// that last changed one of them, see MODES.
+enum Reference {
+    BASE_REF,
+    ONA_REF,
+    MODES_REF,
+    NUM_REFERENCES
+};
+
+static const char *REFERENCE_NAMES[NUM_REFERENCES] = {"base", "ona", "modes"};
+
+struct Pinned {
+    const char *slug;
+    Reference reference;
+};
+
+static const Pinned PINNED[] = {
+    // Hard sync at the sub-sample crossing and subs divided from the main phase
+    {"ONA", ONA_REF},
+    {NULL, BASE_REF}
+};
+
+static Reference referenceFor(const std::string &slug) {
+    for (const Pinned *p = PINNED; p->slug; p++) {
+        if (slug == p->slug) return p->reference;
+    }
+    return BASE_REF;
+}
+
+// How far a module's render may drift from the reference. A channel passes when it is within
+// maxUlp of the reference on every sample, or when the error RMS relative to the reference
+// RMS is below maxErrorDb. Modules not listed here must match bit for bit. An entry covers one
+// output, or all of them with output -1, the first match applies.
+struct Tolerance {
+    const char *slug;
+    int output;
+    uint32_t maxUlp;
+    float maxErrorDb;
+};
+
+static const Tolerance TOLERANCES[] = {
+    // Shaper curves come from interpolated tables instead of float exp/log
+    {"QUART", -1, 0, -120.0f},
+    {"SERRA", -1, 0, -120.0f},
+    // Shared lookup tables for tanh and the pan law; FONT feeds its tanh back into the filter
+    {"FONT", -1, 0, -100.0f},
+    // Channel strips in float_4 with the pan law from a SIMD table lookup
+    {"PerformanceMixer", -1, 0, -120.0f},
+    // The mute gates reach the mixer one sample after EXP4 read them, the reference muted in the same
+    // sample when EXP4 ran first. The test gates on channels 2 and 4 move the slewed mutes of their right
+    // sides, the left sides are panned away by the gates on their pan CVs
+    {"EXP4", 5, 0, -55.0f},
+    {"EXP4", 7, 0, -55.0f},
+    {"EXP4", -1, 0, -120.0f}, // Direct outs come from the mixer
+    // ONA's VCO and LFO pitches come from the shared cent-resolution exp2 table, its sync steps from
+    // the shared MinBLEP table
+    {"ONA", -1, 0, -120.0f},
+    {NULL, -1, 0, 0.0f}
+};
+
+// Inputs left unpatched in the renders, for modules that deliberately changed how they respond
+// to them since the reference. The rest of the module is still held to its tolerance.
+struct Unpatched {
+    const char *slug;
+    int input;
+};
+
+static const Unpatched UNPATCHED[] = {
+    // Poly mute gate input, new since the base reference, rendered in EXP4's poly mode instead
+    {"EXP4", 6},
+    {NULL, 0}
+};
+
+static bool unpatched(const std::string &slug, int input) {
+    for (const Unpatched *u = UNPATCHED; u->slug; u++) {
+        if (slug == u->slug && input == u->input) return true;
+    }
+    return false;
+}
+
+static bench::PortSet renderedInputs(const std::string &slug, size_t inputs) {
+    bench::PortSet set;
+    for (int i = 0; i < (int)inputs; i++) {
+        if (unpatched(slug, i)) set.all = false;
+        else set.ids.push_back(i);
+    }
+    return set;
+}
+
+static Tolerance toleranceFor(const std::string &slug, int output) {
+    for (const Tolerance *t = TOLERANCES; t->slug; t++) {
+        if (slug == t->slug && (t->output == -1 || t->output == output)) return *t;
+    }
+    Tolerance exact = {"", -1, 0, -INFINITY};
+    return exact;
+}
+
+// Param setups every module is rendered with
+enum Scenario {
+    DEFAULT_PARAMS,
+    RANDOM_PARAMS,
+    NUM_SCENARIOS
+};
+
+static const char *SCENARIO_NAMES[NUM_SCENARIOS] = {"default", "random"};
+
+struct Header {
+    uint32_t magic;
+    uint32_t outputs;
+    uint32_t channels;
+    uint32_t frames;
+    float sampleRate;
+};
+
+static bool skipped(const std::string &slug) {
+    for (const char *s : SKIPPED) {
+        if (slug == s) return true;
+    }
+    return false;
+}
+
+// Seeded param values inside each param's range, switches land on whole positions
+static void randomizeParams(Module *m, uint32_t seed) {
+    for (size_t p = 0; p < m->params.size(); p++) {
+        ParamQuantity *q = m->paramQuantities[p];
+        if (!q) continue;
+        seed = seed * 1664525u + 1013904223u;
+        float r = (seed >> 8) * (1.0f / 16777216.0f);
+        float v = q->minValue + r * (q->maxValue - q->minValue);
+        if (q->snapEnabled) v = roundf(v);
+        m->params[p].setValue(v);
+    }
+}
+
+// Runs an item of the module's context menu, like a user picking it. path holds the item texts
+// from the top menu down through the submenus.
+static bool menuAction(Module *m, const std::vector<std::string> &path) {
+    ModuleWidget *widget = m->model->createModuleWidget(m);
+    Menu *menu = new Menu;
+    widget->appendContextMenu(menu);
+    bool done = false;
+    for (size_t level = 0; level < path.size() && menu && !done; level++) {
+        MenuItem *item = NULL;
+        for (Widget *child : menu->children) {
+            MenuItem *candidate = dynamic_cast<MenuItem *>(child);
+            if (candidate && candidate->text == path[level]) {
+                item = candidate;
+                break;
+            }
+        }
+        if (!item) break;
+        if (level + 1 == path.size()) {
+            item->onAction(event::Action());
+            done = true;
+        } else {
+            Menu *childMenu = item->createChildMenu();
+            delete menu;
+            menu = childMenu;
+        }
+    }
+    delete menu;
+    delete widget;
+    if (!done) fprintf(stderr, "%s has no menu item %s\n", m->model->slug.c_str(), path.back().c_str());
+    return done;
+}
+
+// Sets a param by the name it is configured with
+static bool setParam(Module *m, const std::string &name, float value) {
+    for (size_t p = 0; p < m->params.size(); p++) {
+        if (m->paramQuantities[p] && m->paramQuantities[p]->name == name) {
+            m->params[p].setValue(value);
+            return true;
+        }
+    }
+    fprintf(stderr, "%s has no param %s\n", m->model->slug.c_str(), name.c_str());
+    return false;
+}
+
+// Index of the port configured with the given name, -1 if there is none
+static int portId(Module *m, const std::vector<PortInfo *> &infos, const std::string &name) {
+    for (size_t i = 0; i < infos.size(); i++) {
+        if (infos[i] && infos[i]->name == name) return i;
+    }
+    fprintf(stderr, "%s has no port %s\n", m->model->slug.c_str(), name.c_str());
+    return -1;
+}
+
+static int inputId(Module *m, const std::string &name) {
+    return portId(m, m->inputInfos, name);
+}
+
+static int outputId(Module *m, const std::string &name) {
+    return portId(m, m->outputInfos, name);
+}
+
+// Switches the test signal fed to an input of the target
+static bool stimulate(bench::Rig &rig, const std::string &name, bench::Stimulus::Kind kind) {
+    int in = inputId(rig.target, name);
+    if (in < 0) return false;
+    rig.stimuli[0][in].kind = kind;
+    return true;
+}
+
+// The mixer's master and phones are silent at their defaults
+static bool mixerLevels(Module *m) {
+    return setParam(m, "Master Volume", 0.8f) && setParam(m, "Phones Volume", 0.8f);
+}
+
+static const char *EXP4_POLY_GATE = "Mute Gates 1-4, poly, a mono cable mutes all channels";
+static const char *EXP4_POLY_OUT = "Direct outs, poly L1 R1 L2 R2 L3 R3 L4 R4";
+
+// Faders, pans and aux sends of the test scenes, far enough apart that a crossfade is heard
+static const char *SCENE_KNOBS[] = {"Volume", "Panning", "AUX Send"};
+
+static float sceneValue(int scene, int channel, int knob) {
+    if (knob == 0) return 0.2f + 0.25f * ((channel + scene) % 4);
+    if (knob == 1) return scene ? 0.9f - 0.25f * channel : 0.1f + 0.25f * channel;
+    return scene ? 0.5f : -0.5f;
+}
+
+static bool sceneParams(Module *m, int scene) {
+    for (int i = 0; i < 4; i++) {
+        for (int k = 0; k < 3; k++) {
+            if (!setParam(m, string::f("Channel %d %s", i + 1, SCENE_KNOBS[k]), sceneValue(scene, i, k))) return false;
+        }
+    }
+    return true;
+}
+
+// Renders of a module with one of its modes switched on and poly inputs where the mode handles
+// them. The modes are set through the context menu and params and inputs are found by name, so
+// the same table builds against reference trees that predate them. A mode is compared with a
+// reference that has it.
+struct Mode {
+    const char *slug;
+    // No underscores, the render is named <slug>_<name>.f32
+    const char *name;
+    Reference reference;
+    // Polyphony of the patched inputs, and channels of every output written to the render
+    int channels;
+    int recorded;
+    bool (*setup)(bench::Rig &rig);
+    // Called before every frame for modes that change during the render, NULL otherwise
+    bool (*cue)(bench::Rig &rig);
+};
+
+static const Mode MODES[] = {
+    // Wavetable engine, with voices in two groups
+    {"ONA", "wavetable", ONA_REF, 5, 5, [](bench::Rig &rig) {
+        return menuAction(rig.target, {"Band limiting", "Mipmapped wavetables"});
+    }, NULL},
+    // Oversampled linear FM, with an audio rate modulator deep enough to run the phase backwards.
+    // The sync restarts the phase in the oversampled step it crossed in since the ONA reference
+    {"ONA", "fm2x", MODES_REF, 5, 5, [](bench::Rig &rig) {
+        return menuAction(rig.target, {"Linear FM oversampling", "2x"}) && setParam(rig.target, "FM attenuverter", 1.0f) &&
+               stimulate(rig, "FM", bench::Stimulus::SWEEP);
+    }, NULL},
+    {"ONA", "fm4x", MODES_REF, 5, 5, [](bench::Rig &rig) {
+        return menuAction(rig.target, {"Linear FM oversampling", "4x"}) && setParam(rig.target, "FM attenuverter", 1.0f) &&
+               stimulate(rig, "FM", bench::Stimulus::SWEEP);
+    }, NULL},
+    // Unison with more voices than 4 copies take, and 8 copies spread in stereo, at a wide spread
+    {"ONA", "unison4", MODES_REF, 5, 4, [](bench::Rig &rig) {
+        return menuAction(rig.target, {"Unison", "4 copies, up to 4 voices"}) && setParam(rig.target, "Unison spread", 0.6f);
+    }, NULL},
+    {"ONA", "unison8stereo", MODES_REF, 2, 4, [](bench::Rig &rig) {
+        return menuAction(rig.target, {"Unison", "8 copies, up to 2 voices"}) && menuAction(rig.target, {"Unison stereo spread"}) &&
+               setParam(rig.target, "Unison spread", 0.6f);
+    }, NULL},
+    // Poly cables on the channel inputs in each gain mode, master and phones up so the sums are heard
+    {"PerformanceMixer", "polysum", MODES_REF, 5, 2, [](bench::Rig &rig) {
+        return mixerLevels(rig.target);
+    }, NULL},
+    {"PerformanceMixer", "polyaverage", MODES_REF, 16, 2, [](bench::Rig &rig) {
+        return mixerLevels(rig.target) && menuAction(rig.target, {"Poly inputs", "Average the voices"});
+    }, NULL},
+    {"PerformanceMixer", "polypower", MODES_REF, 16, 2, [](bench::Rig &rig) {
+        return mixerLevels(rig.target) && menuAction(rig.target, {"Poly inputs", "Equal power, 1/sqrt(voices)"});
+    }, NULL},
+    // The other pan laws, with the pan CVs sweeping the channels across
+    {"PerformanceMixer", "pan45", MODES_REF, 2, 2, [](bench::Rig &rig) {
+        return mixerLevels(rig.target) && menuAction(rig.target, {"Pan law", "-4.5 dB"});
+    }, NULL},
+    {"PerformanceMixer", "pan6", MODES_REF, 2, 2, [](bench::Rig &rig) {
+        return mixerLevels(rig.target) && menuAction(rig.target, {"Pan law", "-6 dB, linear"});
+    }, NULL},
+    {"PerformanceMixer", "pan0", MODES_REF, 2, 2, [](bench::Rig &rig) {
+        return mixerLevels(rig.target) && menuAction(rig.target, {"Pan law", "0 dB, linear balance"});
+    }, NULL},
+    // Every channel through its insert, with the bands apart and the compressor halfway
+    {"PerformanceMixer", "insert", MODES_REF, 2, 2, [](bench::Rig &rig) {
+        static const float low[] = {0.5f, 2.0f, 1.0f, 0.0f};
+        static const float mid[] = {1.5f, 0.0f, 1.0f, 2.0f};
+        static const float high[] = {2.0f, 1.0f, 0.2f, 1.0f};
+        if (!mixerLevels(rig.target)) return false;
+        for (int i = 0; i < 4; i++) {
+            std::string channel = string::f("Channel %d", i + 1);
+            if (!menuAction(rig.target, {channel + " insert", "EQ and compressor"}) || !setParam(rig.target, channel + " Insert Low Gain", low[i]) ||
+                !setParam(rig.target, channel + " Insert Mid Gain", mid[i]) || !setParam(rig.target, channel + " Insert High Gain", high[i]) ||
+                !setParam(rig.target, channel + " Insert Compression", 0.5f))
+                return false;
+        }
+        return true;
+    }, NULL},
+    // The master clippers, with the master at full so the sum of the channels runs into them
+    {"PerformanceMixer", "softclip", MODES_REF, 2, 2, [](bench::Rig &rig) {
+        return mixerLevels(rig.target) && setParam(rig.target, "Master Volume", 1.0f) &&
+               menuAction(rig.target, {"Master clipper", "Soft clip at 10 V"});
+    }, NULL},
+    {"PerformanceMixer", "hardclip", MODES_REF, 2, 2, [](bench::Rig &rig) {
+        return mixerLevels(rig.target) && setParam(rig.target, "Master Volume", 1.0f) &&
+               menuAction(rig.target, {"Master clipper", "Hard clip at 10 V"});
+    }, NULL},
+    // Two scenes stored at the start, scene 1 recalled with a 100 ms crossfade, scene 2 recalled
+    // halfway through it, then scene 1 again at once
+    {"PerformanceMixer", "scenes", MODES_REF, 2, 2, [](bench::Rig &rig) {
+        return mixerLevels(rig.target) && sceneParams(rig.target, 0) && menuAction(rig.target, {"Scenes", "Store scene 1"}) &&
+               menuAction(rig.target, {"Scenes", "Crossfade time", "100 ms"});
+    }, [](bench::Rig &rig) {
+        Module *m = rig.target;
+        if (rig.frame == 1) return sceneParams(m, 1) && menuAction(m, {"Scenes", "Store scene 2"});
+        if (rig.frame == (int64_t)(0.25f * rig.sampleRate)) return menuAction(m, {"Scenes", "Recall scene 1"});
+        if (rig.frame == (int64_t)(0.3f * rig.sampleRate)) return menuAction(m, {"Scenes", "Recall scene 2"});
+        if (rig.frame == (int64_t)(0.6f * rig.sampleRate))
+            return menuAction(m, {"Scenes", "Crossfade time", "Instant"}) && menuAction(m, {"Scenes", "Recall scene 1"});
+        return true;
+    }},
+    // The poly direct out, with the mutes gated by the poly gate input alone
+    {"EXP4", "poly", MODES_REF, 4, 8, [](bench::Rig &rig) {
+        for (int i = 0; i < 4; i++) {
+            int gate = inputId(rig.target, string::f("Mute Gate %d", i + 1));
+            if (gate < 0) return false;
+            rig.target->inputs[gate].channels = 0;
+        }
+        return stimulate(rig, EXP4_POLY_GATE, bench::Stimulus::GATE);
+    }, NULL},
+    {NULL, NULL, BASE_REF, 0, 0, NULL, NULL}
+};
+
+static bool writeRender(bench::Rig &rig, const std::string &path, uint32_t frames, int recorded, const Mode *mode) {
+    Header h;
+    h.magic = GOLDEN_MAGIC;
+    h.outputs = rig.target->outputs.size();
+    h.channels = recorded;
+    h.frames = frames;
+    h.sampleRate = rig.sampleRate;
+
+    FILE *f = fopen(path.c_str(), "wb");
+    if (!f) {
+        fprintf(stderr, "cannot write %s\n", path.c_str());
+        return false;
+    }
+    fwrite(&h, sizeof(h), 1, f);
+
+    std::vector<float> frame(h.outputs * h.channels);
+    for (uint32_t n = 0; n < frames; n++) {
+        if (mode && mode->cue && !mode->cue(rig)) {
+            fclose(f);
+            return false;
+        }
+        rig.step();
+        for (uint32_t o = 0; o < h.outputs; o++) {
+            // Voltages past the channel count are scratch space, nothing downstream reads them
+            Output &out = rig.target->outputs[o];
+            for (int c = 0; c < recorded; c++) {
+                frame[o * recorded + c] = (c < out.getChannels()) ? out.getVoltage(c) : 0.0f;
+            }
+        }
+        fwrite(frame.data(), sizeof(float), frame.size(), f);
+    }
+    fclose(f);
+    return true;
+}
+
+// Renders every module, or with a reference given only the renders compared against it
+static bool render(Plugin *plugin, const std::string &dir, double seconds, float rate, int reference) {
+    mkdir(dir.c_str(), 0755);
+    uint32_t frames = (uint32_t)(seconds * rate);
+
+    for (Model *model : plugin->models) {
+        if (skipped(model->slug)) continue;
+        bool rendered = false;
+
+        if (reference < 0 || referenceFor(model->slug) == reference) {
+            for (int sc = 0; sc < NUM_SCENARIOS; sc++) {
+                bench::Rig rig;
+                rig.build(plugin, model->slug, rate);
+                rig.patch(renderedInputs(model->slug, rig.target->inputs.size()), bench::PortSet());
+                if (sc == RANDOM_PARAMS) randomizeParams(rig.target, 0x5eed0000u + (uint32_t)model->slug.size());
+
+                std::string path = dir + "/" + model->slug + "_" + SCENARIO_NAMES[sc] + ".f32";
+                if (!writeRender(rig, path, frames, GOLDEN_CHANNELS, NULL)) return false;
+            }
+            rendered = true;
+        }
+
+        for (const Mode *mode = MODES; mode->slug; mode++) {
+            if (model->slug != mode->slug || (reference >= 0 && mode->reference != reference)) continue;
+            bench::Rig rig;
+            rig.build(plugin, model->slug, rate);
+            rig.channels = mode->channels;
+            rig.patch(bench::PortSet(), bench::PortSet());
+            if (!mode->setup(rig)) return false;
+
+            std::string path = dir + "/" + model->slug + "_" + mode->name + ".f32";
+            if (!writeRender(rig, path, frames, mode->recorded, mode)) return false;
+            rendered = true;
+        }
+        if (rendered) printf("rendered %s\n", model->slug.c_str());
+    }
+    return true;
+}
+
+static bool load(const std::string &path, Header &h, std::vector<float> &data) {
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    bool ok = fread(&h, sizeof(h), 1, f) == 1 && h.magic == GOLDEN_MAGIC;
+    if (ok) {
+        data.resize((size_t)h.outputs * h.channels * h.frames);
+        ok = fread(data.data(), sizeof(float), data.size(), f) == data.size();
+    }
+    fclose(f);
+    return ok;
+}
+
+// Distance in representable floats, sign aware so -0 and +0 are equal
+static uint32_t ulpDistance(float a, float b) {
+    int32_t ia, ib;
+    memcpy(&ia, &a, 4);
+    memcpy(&ib, &b, 4);
+    if (ia < 0) ia = INT32_MIN - ia;
+    if (ib < 0) ib = INT32_MIN - ib;
+    int64_t d = (int64_t)ia - (int64_t)ib;
+    return (uint32_t)std::min<int64_t>(d < 0 ? -d : d, UINT32_MAX);
+}
+
+// Compares every render of the reference directories against its namesake in dir
+static bool compare(const std::vector<std::string> &refDirs, const std::string &dir) {
+    // Reference directory and file name of every reference render
+    std::vector<std::pair<std::string, std::string>> files;
+    for (const std::string &refDir : refDirs) {
+        DIR *d = opendir(refDir.c_str());
+        if (!d) {
+            fprintf(stderr, "cannot open %s\n", refDir.c_str());
+            return false;
+        }
+        while (struct dirent *e = readdir(d)) {
+            std::string name = e->d_name;
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".f32") == 0) files.push_back(std::make_pair(refDir, name));
+        }
+        closedir(d);
+    }
+    std::sort(files.begin(), files.end(), [](const std::pair<std::string, std::string> &a, const std::pair<std::string, std::string> &b) {
+        return a.second < b.second;
+    });
+
+    int failures = 0;
+    printf("%-32s %6s %12s %12s %10s  %s\n", "render", "output", "max ulp", "max abs", "err dB", "result");
+    for (const std::pair<std::string, std::string> &file : files) {
+        const std::string &refDir = file.first;
+        const std::string &name = file.second;
+        std::string slug = name.substr(0, name.rfind('_'));
+
+        Header rh, h;
+        std::vector<float> ref, out;
+        if (!load(refDir + "/" + name, rh, ref)) {
+            fprintf(stderr, "bad reference %s\n", name.c_str());
+            failures++;
+            continue;
+        }
+        // Outputs appended since the reference have nothing to compare against, the ones it has must match
+        if (!load(dir + "/" + name, h, out) || h.outputs < rh.outputs || h.channels != rh.channels || h.frames != rh.frames) {
+            printf("%-32s %6s %12s %12s %10s  FAIL (missing or different shape)\n", name.c_str(), "-", "-", "-", "-");
+            failures++;
+            continue;
+        }
+
+        uint32_t width = rh.outputs * rh.channels;
+        uint32_t outWidth = h.outputs * h.channels;
+        for (uint32_t k = 0; k < width; k++) {
+            Tolerance tol = toleranceFor(slug, k / rh.channels);
+            uint32_t maxUlp = 0;
+            float maxAbs = 0.0f;
+            double errSq = 0.0, refSq = 0.0;
+            bool nan = false;
+            for (uint32_t n = 0; n < rh.frames; n++) {
+                float a = ref[(size_t)n * width + k];
+                float b = out[(size_t)n * outWidth + k];
+                if (std::isnan(a) != std::isnan(b)) nan = true;
+                if (std::isnan(a) || std::isnan(b)) continue;
+                maxUlp = std::max(maxUlp, ulpDistance(a, b));
+                maxAbs = std::max(maxAbs, std::fabs(a - b));
+                errSq += (double)(a - b) * (a - b);
+                refSq += (double)a * a;
+            }
+            // A silent reference is compared against 1 V RMS
+            double errDb = (errSq > 0.0) ? 10.0 * log10(errSq / std::max(refSq, (double)rh.frames)) : -INFINITY;
+            bool pass = !nan && (maxUlp <= tol.maxUlp || errDb <= tol.maxErrorDb);
+            if (!pass) failures++;
+            if (!pass || maxUlp > 0) {
+                char output[32];
+                snprintf(output, sizeof(output), "%u.%u", k / rh.channels, k % rh.channels);
+                printf("%-32s %6s %12u %12.3g %10.1f  %s\n", name.c_str(), output, maxUlp, maxAbs, errDb,
+                       nan ? "FAIL (NaN)" : (pass ? "ok" : "FAIL"));
+            }
+        }
+    }
+    printf("%zu renders compared, %d channel(s) out of tolerance\n", files.size(), failures);
+    return failures == 0;
+}
+
+// Properties of the new modes measured on this tree alone, the ones a reference render can't
+// tell apart from a regression. run() says whether the property holds and what it measured.
+struct Check {
+    const char *name;
+    bool (*run)(Plugin *plugin, float rate, std::string &result);
+};
+
+// ONA's unison copies take the voice groups, so 4 copies leave room for 4 voices and 8 for 2, and
+// in stereo every voice has a left and a right channel
+static bool unisonChannels(Plugin *plugin, float rate, std::string &result) {
+    static const char *modes[] = {"4 copies, up to 4 voices", "8 copies, up to 2 voices"};
+    static const int maxVoices[] = {4, 2};
+    for (int u = 0; u < 2; u++) {
+        for (int stereo = 0; stereo < 2; stereo++) {
+            for (int voices = 1; voices <= PORT_MAX_CHANNELS; voices++) {
+                bench::Rig rig;
+                rig.build(plugin, "ONA", rate);
+                rig.channels = voices;
+                rig.patch(bench::PortSet(), bench::PortSet());
+                if (!menuAction(rig.target, {"Unison", modes[u]})) return false;
+                if (stereo && !menuAction(rig.target, {"Unison stereo spread"})) return false;
+                rig.step();
+                int expected = std::min(voices, maxVoices[u]) * (stereo ? 2 : 1);
+                for (Output &out : rig.target->outputs) {
+                    if (out.getChannels() != expected) {
+                        result = string::f("%s%s, %d voices: %d channels, expected %d", modes[u], stereo ? " stereo" : "", voices,
+                                           out.getChannels(), expected);
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    result = "4 and 8 copies, mono and stereo, 1 to 16 voices";
+    return true;
+}
+
+// Master L of the rightmost mixer of a row of PerformanceMixers and EXP4s, all cascaded, after
+// the same 1 V impulse on L1 of every mixer. The impulse comes once the mute slews settled.
+static bool cascadeImpulse(Plugin *plugin, float rate, const std::vector<std::string> &slugs, std::vector<float> &response) {
+    const int settle = 256;
+    bench::Rig rig;
+    if (!rig.buildRow(plugin, slugs, rate)) return false;
+    std::vector<int> impulses;
+    for (Module *m : rig.row) {
+        for (Output &out : m->outputs) out.channels = 1;
+        if (m->model->slug != "PerformanceMixer") continue;
+        int in = inputId(m, "L1");
+        if (in < 0 || !setParam(m, "Master Volume", 1.0f)) return false;
+        m->inputs[in].channels = 1;
+        impulses.push_back(in);
+        if (m != rig.target && !menuAction(m, {"Cascade into the mixer on the right"})) return false;
+    }
+    int master = outputId(rig.target, "L");
+    if (master < 0) return false;
+
+    response.clear();
+    for (int n = 0; n < settle + 16; n++) {
+        size_t mixer = 0;
+        for (Module *m : rig.row) {
+            if (m->model->slug == "PerformanceMixer") m->inputs[impulses[mixer++]].setVoltage(n == settle ? 1.0f : 0.0f);
+        }
+        rig.process();
+        if (n >= settle) response.push_back(rig.target->outputs[master].getVoltage());
+    }
+    return true;
+}
+
+// Every channel of a cascade reaches the master in step: the same impulse on every mixer comes out
+// as one spike, as many times the size of a lone mixer's as there are mixers, one sample later per
+// hop from mixer to mixer and two per hop through an EXP4
+static bool cascadeAlignment(Plugin *plugin, float rate, std::string &result) {
+    std::vector<float> lone;
+    if (!cascadeImpulse(plugin, rate, {"PerformanceMixer"}, lone)) return false;
+    if (lone[0] == 0.0f) {
+        result = "a lone mixer passes no impulse";
+        return false;
+    }
+
+    struct Row {
+        std::vector<std::string> slugs;
+        int mixers;
+        int latency;
+    };
+    const Row rows[] = {
+        {{"PerformanceMixer", "PerformanceMixer", "PerformanceMixer"}, 3, 2},
+        {{"PerformanceMixer", "EXP4", "PerformanceMixer", "EXP4", "PerformanceMixer"}, 3, 4},
+    };
+    for (const Row &row : rows) {
+        std::vector<float> response;
+        if (!cascadeImpulse(plugin, rate, row.slugs, response)) return false;
+        for (int n = 0; n < (int)response.size(); n++) {
+            float expected = (n == row.latency) ? row.mixers * lone[0] : 0.0f;
+            if (std::fabs(response[n] - expected) > 1e-5f * std::fabs(lone[0])) {
+                result = string::f("%zu modules, %g V at sample %d, expected %g V", row.slugs.size(), response[n], n, expected);
+                return false;
+            }
+        }
+    }
+    result = "3 mixers: one spike 2 samples late, with EXP4s between: 4 samples late";
+    return true;
+}
+
+// Master L of a mixer with the same 440 Hz sine on every voice of a poly cable into L1
+static bool polyResponse(Plugin *plugin, float rate, const char *gain, int voices, std::vector<float> &response) {
+    bench::Rig rig;
+    if (!rig.buildRow(plugin, {"PerformanceMixer"}, rate)) return false;
+    Module *m = rig.target;
+    for (Output &out : m->outputs) out.channels = 1;
+    int in = inputId(m, "L1");
+    int master = outputId(m, "L");
+    if (in < 0 || master < 0 || !setParam(m, "Master Volume", 1.0f) || !menuAction(m, {"Poly inputs", gain})) return false;
+    m->inputs[in].channels = voices;
+
+    response.clear();
+    for (int n = 0; n < 1024; n++) {
+        float v = 2.0f * std::sin(2.0f * (float)M_PI * 440.0f * n / rate);
+        for (int c = 0; c < voices; c++) m->inputs[in].setVoltage(v, c);
+        rig.process();
+        response.push_back(m->outputs[master].getVoltage());
+    }
+    return true;
+}
+
+// Poly cables on the mixer channels come out as the mono signal times the voice count when summed,
+// times 1 when averaged and times the square root of the voice count at equal power
+static bool polyGains(Plugin *plugin, float rate, std::string &result) {
+    static const char *gains[] = {"Sum the voices", "Average the voices", "Equal power, 1/sqrt(voices)"};
+    static const int voiceCounts[] = {1, 5, 16};
+    for (int g = 0; g < 3; g++) {
+        std::vector<float> mono;
+        if (!polyResponse(plugin, rate, gains[g], 1, mono)) return false;
+        if (*std::max_element(mono.begin(), mono.end()) < 0.1f) {
+            result = string::f("%s: no signal at the master", gains[g]);
+            return false;
+        }
+        for (int voices : voiceCounts) {
+            float expected = (g == 0) ? voices : (g == 1) ? 1.0f : std::sqrt((float)voices);
+            std::vector<float> poly;
+            if (!polyResponse(plugin, rate, gains[g], voices, poly)) return false;
+            for (size_t n = 0; n < poly.size(); n++) {
+                if (std::fabs(poly[n] - expected * mono[n]) > 1e-5f * expected * 2.0f) {
+                    result = string::f("%s, %d voices: %g V at sample %zu, expected %g V", gains[g], voices, poly[n], n, expected * mono[n]);
+                    return false;
+                }
+            }
+        }
+    }
+    result = "sum, average and equal power with 1, 5 and 16 voices";
+    return true;
+}
+
+// Left gain of each pan law at pan p in [0, 1], the right gain is gain(1 - p)
+static double panGain(int law, double p) {
+    switch (law) {
+        case 1: return std::sqrt((1.0 - p) * std::cos(p * M_PI_2));
+        case 2: return 1.0 - p;
+        case 3: return std::min(2.0 - 2.0 * p, 1.0);
+        default: return std::cos(p * M_PI_2);
+    }
+}
+
+// Master L and R of a mixer with 1 V DC on L1, normalled to R1, at full volume and every pan
+// position in tenths follow the pan law picked in the menu
+static bool panLaws(Plugin *plugin, float rate, std::string &result) {
+    static const char *laws[] = {"-3 dB, equal power", "-4.5 dB", "-6 dB, linear", "0 dB, linear balance"};
+    float maxError = 0.0f;
+    for (int law = 0; law < 4; law++) {
+        bench::Rig rig;
+        if (!rig.buildRow(plugin, {"PerformanceMixer"}, rate)) return false;
+        Module *m = rig.target;
+        for (Output &out : m->outputs) out.channels = 1;
+        int in = inputId(m, "L1");
+        int left = outputId(m, "L");
+        int right = outputId(m, "R");
+        if (in < 0 || left < 0 || right < 0 || !setParam(m, "Master Volume", 1.0f) || !setParam(m, "Channel 1 Volume", 1.0f) ||
+            !menuAction(m, {"Pan law", laws[law]}))
+            return false;
+        m->inputs[in].channels = 1;
+        m->inputs[in].setVoltage(1.0f);
+        for (int step = 0; step <= 10; step++) {
+            double pan = step / 10.0;
+            if (!setParam(m, "Channel 1 Panning", pan)) return false;
+            // Past the mute slew
+            for (int n = 0; n < 256; n++) rig.process();
+            float l = m->outputs[left].getVoltage();
+            float r = m->outputs[right].getVoltage();
+            float el = panGain(law, pan);
+            float er = panGain(law, 1.0 - pan);
+            float error = std::max(std::fabs(l - el), std::fabs(r - er));
+            maxError = std::max(maxError, error);
+            if (error > 1e-4f) {
+                result = string::f("%s at pan %g: %g V, %g V, expected %g V, %g V", laws[law], pan, l, r, el, er);
+                return false;
+            }
+        }
+    }
+    result = string::f("4 laws at 11 pans, within %.2g V of 1 V", maxError);
+    return true;
+}
+
+// Master L of a mixer with the insert of channel 1 on, against the L output of a CEQ with the same
+// settings, both fed the same three tones. The -6 dB law at full left and every gain at 1 leave the
+// mixer's output as the insert's, and the insert's is clamped like CEQ's. Returns the error relative
+// to CEQ's output in dB after the mute slew settled.
+static bool insertError(Plugin *plugin, float rate, float low, float mid, float high, float amount, double &errorDb) {
+    const int settle = 256;
+    bench::Rig mixer, ceq;
+    if (!mixer.buildRow(plugin, {"PerformanceMixer"}, rate) || !ceq.buildRow(plugin, {"CEQ"}, rate)) return false;
+    Module *m = mixer.target;
+    Module *c = ceq.target;
+    for (Output &out : m->outputs) out.channels = 1;
+    for (Output &out : c->outputs) out.channels = 1;
+    int mixerIn = inputId(m, "L1");
+    int mixerOut = outputId(m, "L");
+    int ceqIn = inputId(c, "L");
+    int ceqOut = outputId(c, "L");
+    if (mixerIn < 0 || mixerOut < 0 || ceqIn < 0 || ceqOut < 0) return false;
+    if (!setParam(m, "Master Volume", 1.0f) || !setParam(m, "Channel 1 Volume", 1.0f) || !setParam(m, "Channel 1 Panning", 0.0f) ||
+        !menuAction(m, {"Pan law", "-6 dB, linear"}) || !menuAction(m, {"Channel 1 insert", "EQ and compressor"}) ||
+        !setParam(m, "Channel 1 Insert Low Gain", low) || !setParam(m, "Channel 1 Insert Mid Gain", mid) ||
+        !setParam(m, "Channel 1 Insert High Gain", high) || !setParam(m, "Channel 1 Insert Compression", amount))
+        return false;
+    if (!setParam(c, "Low frequency gain", low) || !setParam(c, "Mid frequency gain", mid) || !setParam(c, "High frequency gain", high) ||
+        !setParam(c, "Compression amount", amount))
+        return false;
+    m->inputs[mixerIn].channels = 1;
+    c->inputs[ceqIn].channels = 1;
+
+    double errSq = 0.0, refSq = 0.0;
+    for (int n = 0; n < settle + 8192; n++) {
+        float t = n / rate;
+        float v = 1.5f * (std::sin(2.0f * (float)M_PI * 110.0f * t) + std::sin(2.0f * (float)M_PI * 1000.0f * t) +
+                          std::sin(2.0f * (float)M_PI * 6000.0f * t));
+        m->inputs[mixerIn].setVoltage(v);
+        c->inputs[ceqIn].setVoltage(v);
+        mixer.process();
+        ceq.process();
+        if (n < settle) continue;
+        float a = c->outputs[ceqOut].getVoltage();
+        float b = clamp(m->outputs[mixerOut].getVoltage(), -11.0f, 11.0f);
+        errSq += (double)(a - b) * (a - b);
+        refSq += (double)a * a;
+    }
+    errorDb = (errSq > 0.0) ? 10.0 * log10(errSq / refSq) : -INFINITY;
+    return refSq > 0.0;
+}
+
+// A channel insert is CEQ: the EQ matches it to float rounding, the compressor to the accuracy of
+// the fast log and exp it runs on
+static bool insertMatchesCeq(Plugin *plugin, float rate, std::string &result) {
+    struct Setting {
+        const char *name;
+        float low, mid, high, amount;
+        double maxErrorDb;
+    };
+    static const Setting settings[] = {
+        {"flat", 1.0f, 1.0f, 1.0f, 0.0f, -130.0},
+        {"EQ", 0.5f, 1.5f, 2.0f, 0.0f, -130.0},
+        {"EQ and full compression", 0.5f, 1.5f, 2.0f, 1.0f, -65.0},
+    };
+    result.clear();
+    for (const Setting &s : settings) {
+        double errorDb;
+        if (!insertError(plugin, rate, s.low, s.mid, s.high, s.amount, errorDb)) {
+            result = string::f("%s: no signal from CEQ", s.name);
+            return false;
+        }
+        result += string::f("%s%s %.1f dB", result.empty() ? "" : ", ", s.name, errorDb);
+        if (errorDb > s.maxErrorDb) {
+            result += string::f(", expected below %.0f dB", s.maxErrorDb);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Largest master L of a lone mixer with a 1 kHz sine of the given peak on L1, and its master L
+// at the end of the render, through the given master clipper
+static bool clipperResponse(Plugin *plugin, float rate, const char *clip, float peak, float &maxOut, float &lastOut) {
+    bench::Rig rig;
+    if (!rig.buildRow(plugin, {"PerformanceMixer"}, rate)) return false;
+    Module *m = rig.target;
+    for (Output &out : m->outputs) out.channels = 1;
+    int in = inputId(m, "L1");
+    int master = outputId(m, "L");
+    if (in < 0 || master < 0 || !setParam(m, "Master Volume", 1.0f) || !setParam(m, "Channel 1 Volume", 1.0f) ||
+        !menuAction(m, {"Master clipper", clip}))
+        return false;
+    m->inputs[in].channels = 1;
+
+    maxOut = 0.0f;
+    for (int n = 0; n < 4096; n++) {
+        // DC for the last samples, so the output settles on one value
+        float v = (n < 4000) ? peak * std::sin(2.0f * (float)M_PI * 1000.0f * n / rate) : peak;
+        m->inputs[in].setVoltage(v);
+        rig.process();
+        lastOut = m->outputs[master].getVoltage();
+        maxOut = std::max(maxOut, std::fabs(lastOut));
+    }
+    return true;
+}
+
+// The master clippers hold a 20 V sine to 10 V and pass a signal well below it at unity gain
+static bool clipperLevels(Plugin *plugin, float rate, std::string &result) {
+    static const char *clips[] = {"Soft clip at 10 V", "Hard clip at 10 V"};
+    float dryMax, dry;
+    if (!clipperResponse(plugin, rate, "Off", 1.0f, dryMax, dry)) return false;
+    for (const char *clip : clips) {
+        float loudMax, loud, quietMax, quiet;
+        if (!clipperResponse(plugin, rate, clip, 20.0f, loudMax, loud) || !clipperResponse(plugin, rate, clip, 1.0f, quietMax, quiet))
+            return false;
+        if (loudMax > 10.0f + 1e-4f || loudMax < 9.0f) {
+            result = string::f("%s: %g V peak from a 20 V sine, expected up to 10 V", clip, loudMax);
+            return false;
+        }
+        if (std::fabs(quiet - dry) > 1e-3f * std::fabs(dry)) {
+            result = string::f("%s: %g V from %g V", clip, quiet, dry);
+            return false;
+        }
+    }
+    result = "soft and hard: 20 V sines within 10 V, 1 V through at unity gain";
+    return true;
+}
+
+// Whether the faders, pans and aux sends of the mixer are the ones of the test scenes mixed by
+// amount, within tolerance
+static bool sceneMix(Module *m, float amount, float tolerance, std::string &result) {
+    for (int i = 0; i < 4; i++) {
+        for (int k = 0; k < 3; k++) {
+            std::string name = string::f("Channel %d %s", i + 1, SCENE_KNOBS[k]);
+            float expected = (1.0f - amount) * sceneValue(0, i, k) + amount * sceneValue(1, i, k);
+            for (size_t p = 0; p < m->params.size(); p++) {
+                if (!m->paramQuantities[p] || m->paramQuantities[p]->name != name) continue;
+                float value = m->params[p].getValue();
+                if (std::fabs(value - expected) > tolerance) {
+                    result = string::f("%s at %g, expected %g", name.c_str(), value, expected);
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// A recalled scene crossfades the knobs from where they are to the stored values in the time set,
+// and lands on them exactly
+static bool sceneRecall(Plugin *plugin, float rate, std::string &result) {
+    bench::Rig rig;
+    if (!rig.buildRow(plugin, {"PerformanceMixer"}, rate)) return false;
+    Module *m = rig.target;
+    if (!sceneParams(m, 0) || !menuAction(m, {"Scenes", "Store scene 1"})) return false;
+    rig.process();
+    if (!sceneParams(m, 1) || !menuAction(m, {"Scenes", "Store scene 2"}) || !menuAction(m, {"Scenes", "Crossfade time", "100 ms"})) return false;
+    rig.process();
+
+    // Scene 2 is on the panel, scene 1 comes back over 100 ms
+    int fade = (int)(0.1f * rate);
+    if (!menuAction(m, {"Scenes", "Recall scene 1"})) return false;
+    for (int n = 0; n < fade / 2; n++) rig.process();
+    if (!sceneMix(m, 0.5f, 1e-3f, result)) {
+        result = "halfway: " + result;
+        return false;
+    }
+    for (int n = fade / 2; n < fade + 1; n++) rig.process();
+    if (!sceneMix(m, 0.0f, 0.0f, result)) {
+        result = "after 100 ms: " + result;
+        return false;
+    }
+
+    // Instant recalls land on the next sample
+    if (!menuAction(m, {"Scenes", "Crossfade time", "Instant"}) || !menuAction(m, {"Scenes", "Recall scene 2"})) return false;
+    rig.process();
+    if (!sceneMix(m, 1.0f, 0.0f, result)) {
+        result = "instant: " + result;
+        return false;
+    }
+    result = "halfway through 100 ms, exact at its end and at once with no crossfade";
+    return true;
+}
+
+// EXP4 next to a mixer with a different sine on each channel, gated between samples 512 and 1536
+// on the mono mute gates in monoGates, a bit per channel, and on the channels in polyGates of a
+// poly gate cable of polyChannels. Every frame holds EXP4's direct outs, the 8 channels of its
+// poly out and the mixer's master L and R.
+static bool exp4Response(Plugin *plugin, float rate, int monoGates, int polyChannels, int polyGates, std::vector<float> &frames) {
+    bench::Rig rig;
+    if (!rig.buildRow(plugin, {"EXP4", "PerformanceMixer"}, rate)) return false;
+    Module *exp4 = rig.row[0];
+    Module *m = rig.target;
+    for (Output &out : exp4->outputs) out.channels = 1;
+    for (Output &out : m->outputs) out.channels = 1;
+    if (!setParam(m, "Master Volume", 1.0f)) return false;
+
+    int channelIns[4], monoIns[4], directOuts[8];
+    for (int i = 0; i < 4; i++) {
+        channelIns[i] = inputId(m, string::f("L%d", i + 1));
+        monoIns[i] = inputId(exp4, string::f("Mute Gate %d", i + 1));
+        directOuts[2 * i] = outputId(exp4, string::f("L%d", i + 1));
+        directOuts[2 * i + 1] = outputId(exp4, string::f("R%d", i + 1));
+        if (channelIns[i] < 0 || monoIns[i] < 0 || directOuts[2 * i] < 0 || directOuts[2 * i + 1] < 0) return false;
+        m->inputs[channelIns[i]].channels = 1;
+        exp4->inputs[monoIns[i]].channels = (monoGates >> i) & 1;
+    }
+    int polyIn = inputId(exp4, EXP4_POLY_GATE);
+    int polyOut = outputId(exp4, EXP4_POLY_OUT);
+    int left = outputId(m, "L");
+    int right = outputId(m, "R");
+    if (polyIn < 0 || polyOut < 0 || left < 0 || right < 0) return false;
+    exp4->inputs[polyIn].channels = polyChannels;
+
+    frames.clear();
+    for (int n = 0; n < 2048; n++) {
+        float gate = (n >= 512 && n < 1536) ? 10.0f : 0.0f;
+        for (int i = 0; i < 4; i++) {
+            m->inputs[channelIns[i]].setVoltage(2.0f * std::sin(2.0f * (float)M_PI * 110.0f * (i + 1) * n / rate));
+            // Unpatched inputs read 0 V, like Rack leaves them
+            exp4->inputs[monoIns[i]].setVoltage(((monoGates >> i) & 1) ? gate : 0.0f);
+        }
+        for (int c = 0; c < polyChannels; c++) exp4->inputs[polyIn].setVoltage(((polyGates >> c) & 1) ? gate : 0.0f, c);
+        rig.process();
+        for (int k = 0; k < 8; k++) frames.push_back(exp4->outputs[directOuts[k]].getVoltage());
+        for (int c = 0; c < 8; c++) frames.push_back(c < exp4->outputs[polyOut].getChannels() ? exp4->outputs[polyOut].getVoltage(c) : NAN);
+        frames.push_back(m->outputs[left].getVoltage());
+        frames.push_back(m->outputs[right].getVoltage());
+    }
+    return true;
+}
+
+// EXP4's poly out carries its direct outs L1 R1 L2 R2 and so on, and a channel of the poly gate
+// mutes like the mono gate of its channel, a mono cable like all four
+static bool exp4Poly(Plugin *plugin, float rate, std::string &result) {
+    const size_t width = 18;
+    std::vector<float> open;
+    if (!exp4Response(plugin, rate, 0, 0, 0, open)) return false;
+    bool heard = false;
+    for (size_t n = 0; n < open.size() / width; n++) {
+        const float *frame = &open[n * width];
+        for (int c = 0; c < 8; c++) {
+            if (!(frame[8 + c] == frame[c])) {
+                result = string::f("poly out channel %d at %g V, direct out at %g V at sample %zu", c + 1, frame[8 + c], frame[c], n);
+                return false;
+            }
+            heard |= frame[c] != 0.0f;
+        }
+    }
+    if (!heard) {
+        result = "no signal at the direct outs";
+        return false;
+    }
+
+    struct Gates {
+        int monoGates, polyChannels, polyGates;
+        const char *name;
+    };
+    const Gates cases[] = {
+        {1, 4, 1, "channel 1"}, {2, 4, 2, "channel 2"}, {4, 4, 4, "channel 3"}, {8, 4, 8, "channel 4"}, {15, 1, 1, "a mono cable"},
+    };
+    for (const Gates &g : cases) {
+        std::vector<float> mono, poly;
+        if (!exp4Response(plugin, rate, g.monoGates, 0, 0, mono) || !exp4Response(plugin, rate, 0, g.polyChannels, g.polyGates, poly))
+            return false;
+        if (mono == open) {
+            result = string::f("the mono gate of %s mutes nothing", g.name);
+            return false;
+        }
+        for (size_t k = 0; k < mono.size(); k++) {
+            if (!(poly[k] == mono[k])) {
+                result = string::f("poly gate on %s: %g V at sample %zu, %g V with the mono gate", g.name, poly[k], k / width, mono[k]);
+                return false;
+            }
+        }
+    }
+    result = "poly out matches the direct outs, poly gates mute like the mono ones";
+    return true;
+}
+
+static const Check CHECKS[] = {
+    {"ONA unison channels", unisonChannels},
+    {"PerformanceMixer cascade", cascadeAlignment},
+    {"PerformanceMixer poly gains", polyGains},
+    {"PerformanceMixer pan laws", panLaws},
+    {"PerformanceMixer insert vs CEQ", insertMatchesCeq},
+    {"PerformanceMixer master clipper", clipperLevels},
+    {"PerformanceMixer scene recall", sceneRecall},
+    {"EXP4 poly", exp4Poly},
+    {NULL, NULL}
+};
+
+static bool check(Plugin *plugin, float rate) {
+    int failures = 0;
+    for (const Check *c = CHECKS; c->name; c++) {
+        std::string result;
+        bool pass = c->run(plugin, rate, result);
+        if (!pass) failures++;
+        printf("%-32s %s  %s\n", c->name, pass ? "ok" : "FAIL", result.c_str());
+    }
+    printf("%d check(s) failed\n", failures);
+    return failures == 0;
+}
+
+int main(int argc, char **argv) {
+    std::string mode = (argc > 1) ? argv[1] : "";
+    if (mode == "render" && argc >= 3) {
+        double seconds = 1.0;
+        float rate = 44100.0f;
+        int reference = -1;
+        for (int i = 3; i + 1 < argc; i += 2) {
+            if (!strcmp(argv[i], "--seconds")) seconds = atof(argv[i + 1]);
+            else if (!strcmp(argv[i], "--rate")) rate = atof(argv[i + 1]);
+            else if (!strcmp(argv[i], "--reference")) {
+                for (int r = 0; r < NUM_REFERENCES; r++) {
+                    if (!strcmp(argv[i + 1], REFERENCE_NAMES[r])) reference = r;
+                }
+                if (reference < 0) {
+                    fprintf(stderr, "unknown reference %s\n", argv[i + 1]);
+                    return 1;
+                }
+            }
+        }
+        bench::setEngineFloatMode();
+        Plugin plugin;
+        init(&plugin);
+        return render(&plugin, argv[2], seconds, rate, reference) ? 0 : 1;
+    }
+    if (mode == "compare" && argc >= 4) {
+        return compare(std::vector<std::string>(argv + 2, argv + argc - 1), argv[argc - 1]) ? 0 : 1;
+    }
+    if (mode == "check") {
+        bench::setEngineFloatMode();
+        Plugin plugin;
+        init(&plugin);
+        return check(&plugin, 44100.0f) ? 0 : 1;
+    }
+    fprintf(stderr, "usage: %s render DIR [--seconds S] [--rate HZ] [--reference NAME]\n       %s compare REF_DIR... DIR\n       %s check\n",
+            argv[0], argv[0], argv[0]);
+    return 1;
+}
@@ -0,0 +1,285 @@
+//
+//  harness.hpp
+//
+//  Headless rig shared by the benchmark and the golden renderer.
+//  Instantiates NANO models against the stub engine, wires expanders like Rack does,
+//  patches ports on demand and feeds connected inputs with deterministic test signals.
+//
+
+#ifndef BENCH_HARNESS_HPP
+#define BENCH_HARNESS_HPP
+
+#include <rack.hpp>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <xmmintrin.h>
+#endif
+
+using namespace rack;
+
+// Defined by src/plugin.cpp
+extern Plugin *pluginInstance;
+void init(Plugin *p);
+
+namespace bench {
+
+// Modules that do nothing useful alone get their partner placed on the given side
+struct Partner {
+    const char *slug;
+    const char *partnerSlug;
+    bool partnerOnRight;
+};
+
+static const Partner PARTNERS[] = {
+    {"EXP4", "PerformanceMixer", true},
+};
+
+// Set of port indices, parsed from "all", "none" or a comma separated list like "0,3,7"
+struct PortSet {
+    bool all = true;
+    std::vector<int> ids;
+
+    static PortSet parse(const std::string &spec) {
+        PortSet set;
+        if (spec == "all") {
+            return set;
+        }
+        set.all = false;
+        if (spec == "none") {
+            return set;
+        }
+        size_t start = 0;
+        while (start < spec.size()) {
+            size_t end = spec.find(',', start);
+            if (end == std::string::npos) end = spec.size();
+            set.ids.push_back(std::atoi(spec.substr(start, end - start).c_str()));
+            start = end + 1;
+        }
+        return set;
+    }
+
+    bool contains(int id) const {
+        if (all) return true;
+        for (int i : ids) {
+            if (i == id) return true;
+        }
+        return false;
+    }
+
+    std::string describe() const {
+        if (all) return "all";
+        if (ids.empty()) return "none";
+        std::string s;
+        for (size_t i = 0; i < ids.size(); i++) {
+            s += (i ? "," : "") + std::to_string(ids[i]);
+        }
+        return s;
+    }
+};
+
+// Deterministic per-input test signals: audio sweep, gate train, seeded noise and a slow LFO
+struct Stimulus {
+    enum Kind {
+        SWEEP,
+        GATE,
+        NOISE,
+        LFO,
+        NUM_KINDS
+    };
+
+    Kind kind = SWEEP;
+    double phase = 0.0;
+    double time = 0.0;
+    uint32_t seed = 1;
+
+    void init(int inputId) {
+        kind = (Kind)(inputId % NUM_KINDS);
+        phase = 0.0;
+        time = 0.0;
+        seed = 0x9e3779b9u * (uint32_t)(inputId + 1);
+    }
+
+    float process(double sampleTime) {
+        float out = 0.0f;
+        switch (kind) {
+            case SWEEP: {
+                // Exponential 20 Hz -> 20 kHz sweep over 4 seconds, repeated
+                double t = fmod(time, 4.0);
+                double freq = 20.0 * pow(1000.0, t / 4.0);
+                phase += freq * sampleTime;
+                phase -= floor(phase);
+                out = 5.0f * (float)sin(2.0 * M_PI * phase);
+                break;
+            }
+            case GATE: {
+                // 4 Hz gates with a 30% duty cycle
+                double p = fmod(time * 4.0, 1.0);
+                out = (p < 0.3) ? 10.0f : 0.0f;
+                break;
+            }
+            case NOISE: {
+                // Numerical Recipes LCG, same sequence on every platform
+                seed = seed * 1664525u + 1013904223u;
+                out = ((seed >> 8) * (1.0f / 16777216.0f) * 2.0f - 1.0f) * 5.0f;
+                break;
+            }
+            case LFO: {
+                // 0.5 Hz triangle between -5 V and 5 V
+                double p = fmod(time * 0.5, 1.0);
+                out = (float)(20.0 * fabs(p - 0.5) - 5.0);
+                break;
+            }
+            default:
+                break;
+        }
+        time += sampleTime;
+        return out;
+    }
+};
+
+// A row of modules processed like one Rack engine thread, left to right
+struct Rig {
+    std::vector<Module *> row;
+    std::vector<std::vector<Stimulus>> stimuli;
+    Module *target = NULL;
+    float sampleRate = 44100.0f;
+    // Polyphony of the target's patched inputs
+    int channels = 1;
+    int64_t frame = 0;
+
+    ~Rig() {
+        for (Module *m : row) delete m;
+    }
+
+    // Builds the target module plus its partner if it needs one, returns false for unknown slugs
+    bool build(Plugin *plugin, const std::string &slug, float rate) {
+        sampleRate = rate;
+        APP->engine->sampleRate = rate;
+
+        Model *model = plugin->getModel(slug);
+        if (!model) return false;
+        target = model->createModule();
+        row.push_back(target);
+
+        for (const Partner &p : PARTNERS) {
+            if (slug != p.slug) continue;
+            Model *partnerModel = plugin->getModel(p.partnerSlug);
+            if (!partnerModel) continue;
+            Module *partner = partnerModel->createModule();
+            if (p.partnerOnRight) row.push_back(partner);
+            else row.insert(row.begin(), partner);
+        }
+        connect(rate);
+        return true;
+    }
+
+    // Builds the given modules side by side from left to right, the target is the rightmost one.
+    // Nothing is patched, the caller drives the inputs and steps the row with process().
+    bool buildRow(Plugin *plugin, const std::vector<std::string> &slugs, float rate) {
+        sampleRate = rate;
+        APP->engine->sampleRate = rate;
+
+        for (const std::string &slug : slugs) {
+            Model *model = plugin->getModel(slug);
+            if (!model) return false;
+            row.push_back(model->createModule());
+        }
+        target = row.back();
+        connect(rate);
+        return true;
+    }
+
+    // Wires the expanders of neighbours like Rack does and sets the sample rate
+    void connect(float rate) {
+        for (size_t i = 0; i < row.size(); i++) {
+            row[i]->id = (int64_t)i + 1;
+            row[i]->leftExpander.module = (i > 0) ? row[i - 1] : NULL;
+            row[i]->leftExpander.moduleId = (i > 0) ? row[i - 1]->id : -1;
+            row[i]->rightExpander.module = (i + 1 < row.size()) ? row[i + 1] : NULL;
+            row[i]->rightExpander.moduleId = (i + 1 < row.size()) ? row[i + 1]->id : -1;
+            Module::SampleRateChangeEvent e;
+            e.sampleRate = rate;
+            e.sampleTime = 1.0f / rate;
+            row[i]->onSampleRateChange(e);
+        }
+    }
+
+    // Patches the target's ports, every connected input gets its own test signal
+    void patch(const PortSet &ins, const PortSet &outs) {
+        stimuli.assign(row.size(), std::vector<Stimulus>());
+        for (size_t m = 0; m < row.size(); m++) {
+            Module *module = row[m];
+            stimuli[m].resize(module->inputs.size());
+            for (size_t i = 0; i < module->inputs.size(); i++) {
+                module->inputs[i].channels = (module != target) ? 1 : (ins.contains(i) ? channels : 0);
+                stimuli[m][i].init(i);
+            }
+            for (size_t o = 0; o < module->outputs.size(); o++) {
+                module->outputs[o].channels = (module != target || outs.contains(o)) ? 1 : 0;
+            }
+        }
+    }
+
+    // Writes the next stimulus sample into every connected input, poly channels are spread a semitone apart
+    void feed() {
+        double sampleTime = 1.0 / sampleRate;
+        for (size_t m = 0; m < row.size(); m++) {
+            for (size_t i = 0; i < row[m]->inputs.size(); i++) {
+                Input &in = row[m]->inputs[i];
+                if (!in.channels) continue;
+                float v = stimuli[m][i].process(sampleTime);
+                for (int c = 0; c < in.channels; c++) in.setVoltage(v + c / 12.0f, c);
+            }
+        }
+    }
+
+    Module::ProcessArgs args() const {
+        Module::ProcessArgs a;
+        a.sampleRate = sampleRate;
+        a.sampleTime = 1.0f / sampleRate;
+        a.frame = frame;
+        return a;
+    }
+
+    // Rack flips every requested expander message once all modules ran for the frame
+    void flipMessages() {
+        for (Module *m : row) {
+            Module::Expander *sides[2] = {&m->leftExpander, &m->rightExpander};
+            for (Module::Expander *e : sides) {
+                if (e->messageFlipRequested) {
+                    std::swap(e->producerMessage, e->consumerMessage);
+                    e->messageFlipRequested = false;
+                }
+            }
+        }
+    }
+
+    // Processes one frame of every module in the row
+    void step() {
+        feed();
+        process();
+    }
+
+    // Processes one frame with the inputs as they are
+    void process() {
+        Module::ProcessArgs a = args();
+        for (Module *m : row) m->process(a);
+        flipMessages();
+        frame++;
+    }
+};
+
+// Rack's engine threads run with denormals flushed to zero, so the harness does too
+inline void setEngineFloatMode() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_setcsr(_mm_getcsr() | 0x8040); // FTZ | DAZ
+#endif
+}
+
+} // namespace bench
+
+#endif // BENCH_HARNESS_HPP
@@ -0,0 +1,91 @@
+//
+//  componentlibrary.hpp (bench stub)
+//
+//  Inert versions of the Rack component library widgets used by the NANO panels.
+//
+
+#pragma once
+
+#include "rack.hpp"
+
+namespace rack {
+namespace componentlibrary {
+
+// Lights
+
+struct RedLight : app::ModuleLightWidget {};
+struct WhiteLight : app::ModuleLightWidget {};
+struct GreenLight : app::ModuleLightWidget {};
+struct BlueLight : app::ModuleLightWidget {};
+struct YellowLight : app::ModuleLightWidget {};
+struct GreenRedLight : app::ModuleLightWidget {};
+struct RedGreenBlueLight : app::ModuleLightWidget {};
+
+template <typename TBase = app::ModuleLightWidget>
+struct TSvgLight : TBase {};
+
+template <typename TBase>
+struct SmallLight : TSvgLight<TBase> {};
+template <typename TBase>
+struct MediumLight : TSvgLight<TBase> {};
+template <typename TBase>
+struct LargeLight : TSvgLight<TBase> {};
+
+// Knobs
+
+struct RoundKnob : app::SvgKnob {};
+struct Davies1900hKnob : app::SvgKnob {};
+struct Davies1900hWhiteKnob : Davies1900hKnob {};
+struct Davies1900hBlackKnob : Davies1900hKnob {};
+struct Davies1900hRedKnob : Davies1900hKnob {};
+struct Davies1900hLargeWhiteKnob : Davies1900hKnob {};
+struct Davies1900hLargeBlackKnob : Davies1900hKnob {};
+struct Trimpot : app::SvgKnob {};
+
+// Sliders
+
+struct VCVSlider : app::SvgSlider {};
+
+template <typename TLightBase = RedLight>
+struct VCVLightSlider : VCVSlider {
+	app::ModuleLightWidget* light;
+	VCVLightSlider() {
+		light = new TLightBase;
+		addChild(light);
+	}
+	app::ModuleLightWidget* getLight() {
+		return light;
+	}
+};
+
+using LEDSliderRed = VCVLightSlider<RedLight>;
+using LEDSliderWhite = VCVLightSlider<WhiteLight>;
+using LEDSliderGreen = VCVLightSlider<GreenLight>;
+
+// Ports
+
+struct PJ301MPort : app::SvgPort {};
+
+// Switches and buttons
+
+struct LEDButton : app::SvgSwitch {};
+struct VCVButton : app::SvgSwitch {};
+struct CKSS : app::SvgSwitch {};
+struct PB61303 : app::SvgSwitch {};
+
+template <typename TLight>
+struct PB61303Light : TLight {};
+
+template <typename TLight>
+struct VCVBezelLight : TLight {};
+
+// Misc
+
+struct ScrewSilver : app::SvgScrew {};
+struct ScrewBlack : app::SvgScrew {};
+
+} // namespace componentlibrary
+
+using namespace componentlibrary;
+
+} // namespace rack
@@ -0,0 +1,100 @@
+//
+//  context.cpp (bench stub)
+//
+//  The single global context the modules reach through APP, and the few Rack DSP
+//  functions that are not header-only.
+//
+
+#include "rack.hpp"
+
+#include <complex>
+#include <vector>
+
+namespace rack {
+
+static engine::Engine stubEngine;
+static window::Window stubWindow;
+static Context stubContext;
+
+Context* contextGet() {
+	if (!stubContext.engine) {
+		stubContext.engine = &stubEngine;
+		stubContext.window = &stubWindow;
+	}
+	return &stubContext;
+}
+
+namespace dsp {
+
+// In place radix-2 FFT, n a power of 2
+static void fft(std::vector<std::complex<double>>& x, bool inverse) {
+	size_t n = x.size();
+	for (size_t i = 1, j = 0; i < n; i++) {
+		size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+		if (i < j)
+			std::swap(x[i], x[j]);
+	}
+	for (size_t len = 2; len <= n; len <<= 1) {
+		double angle = 2.0 * M_PI / len * (inverse ? 1 : -1);
+		std::complex<double> w(std::cos(angle), std::sin(angle));
+		for (size_t i = 0; i < n; i += len) {
+			std::complex<double> wk(1.0);
+			for (size_t k = 0; k < len / 2; k++) {
+				std::complex<double> a = x[i + k];
+				std::complex<double> b = x[i + k + len / 2] * wk;
+				x[i + k] = a + b;
+				x[i + k + len / 2] = a - b;
+				wk *= w;
+			}
+		}
+	}
+	if (inverse) {
+		for (size_t i = 0; i < n; i++)
+			x[i] /= (double) n;
+	}
+}
+
+// Same construction as Rack: Blackman-Harris windowed sinc, minimum phase through the real cepstrum, integrated
+void minBlepImpulse(int z, int o, float* output) {
+	int n = 2 * z * o;
+	std::vector<std::complex<double>> x(n);
+	for (int i = 0; i < n; i++) {
+		double p = -z + 2.0 * z * i / (n - 1);
+		double sinc = (p == 0.0) ? 1.0 : std::sin(M_PI * p) / (M_PI * p);
+		double t = 2.0 * M_PI * i / (n - 1);
+		double window = 0.35875 - 0.48829 * std::cos(t) + 0.14128 * std::cos(2 * t) - 0.01168 * std::cos(3 * t);
+		x[i] = sinc * window;
+	}
+
+	// Real cepstrum
+	fft(x, false);
+	for (int i = 0; i < n; i++)
+		x[i] = std::max(-30.0, std::log(std::abs(x[i])));
+	fft(x, true);
+
+	// Minimum-phase reconstruction
+	for (int i = 1; i < n / 2; i++)
+		x[i] *= 2.0;
+	for (int i = n / 2 + 1; i < n; i++)
+		x[i] = 0.0;
+	fft(x, false);
+	for (int i = 0; i < n; i++)
+		x[i] = std::exp(x[i]);
+	fft(x, true);
+
+	// Integrate and normalize
+	double total = 0.0;
+	for (int i = 0; i < n; i++) {
+		total += x[i].real();
+		x[i] = total;
+	}
+	for (int i = 0; i < n; i++)
+		output[i] = (float) (x[i].real() / total);
+}
+
+} // namespace dsp
+
+} // namespace rack
@@ -0,0 +1,154 @@
+//
+//  jansson.h (bench stub)
+//
+//  The handful of jansson calls the NANO modules make for patch storage, backed by a tiny tree.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct json_t {
+	enum Type { OBJECT, ARRAY, BOOLEAN, INTEGER, REAL, STRING, NUL };
+	Type type = NUL;
+	bool b = false;
+	long long i = 0;
+	double r = 0.0;
+	std::string s;
+	std::vector<json_t*> items;
+	std::vector<std::pair<std::string, json_t*>> fields;
+
+	~json_t() {
+		for (json_t* item : items)
+			delete item;
+		for (auto& field : fields)
+			delete field.second;
+	}
+};
+
+typedef long long json_int_t;
+
+inline json_t* json_object() {
+	json_t* j = new json_t;
+	j->type = json_t::OBJECT;
+	return j;
+}
+
+inline int json_object_set_new(json_t* object, const char* key, json_t* value) {
+	if (!object || !value)
+		return -1;
+	for (auto& field : object->fields) {
+		if (field.first == key) {
+			delete field.second;
+			field.second = value;
+			return 0;
+		}
+	}
+	object->fields.emplace_back(key, value);
+	return 0;
+}
+
+inline json_t* json_object_get(const json_t* object, const char* key) {
+	if (!object || object->type != json_t::OBJECT)
+		return NULL;
+	for (auto& field : object->fields)
+		if (field.first == key)
+			return field.second;
+	return NULL;
+}
+
+inline json_t* json_array() {
+	json_t* j = new json_t;
+	j->type = json_t::ARRAY;
+	return j;
+}
+
+inline int json_array_append_new(json_t* array, json_t* value) {
+	if (!array || !value)
+		return -1;
+	array->items.push_back(value);
+	return 0;
+}
+
+inline size_t json_array_size(const json_t* array) {
+	return (array && array->type == json_t::ARRAY) ? array->items.size() : 0;
+}
+
+inline json_t* json_array_get(const json_t* array, size_t index) {
+	if (index >= json_array_size(array))
+		return NULL;
+	return array->items[index];
+}
+
+inline json_t* json_boolean(bool value) {
+	json_t* j = new json_t;
+	j->type = json_t::BOOLEAN;
+	j->b = value;
+	return j;
+}
+
+inline json_t* json_true() {
+	return json_boolean(true);
+}
+
+inline json_t* json_false() {
+	return json_boolean(false);
+}
+
+inline bool json_boolean_value(const json_t* j) {
+	return j && j->type == json_t::BOOLEAN && j->b;
+}
+
+inline bool json_is_true(const json_t* j) {
+	return json_boolean_value(j);
+}
+
+inline json_t* json_integer(json_int_t value) {
+	json_t* j = new json_t;
+	j->type = json_t::INTEGER;
+	j->i = value;
+	return j;
+}
+
+inline json_int_t json_integer_value(const json_t* j) {
+	return (j && j->type == json_t::INTEGER) ? j->i : 0;
+}
+
+inline json_t* json_real(double value) {
+	json_t* j = new json_t;
+	j->type = json_t::REAL;
+	j->r = value;
+	return j;
+}
+
+inline double json_real_value(const json_t* j) {
+	return (j && j->type == json_t::REAL) ? j->r : 0.0;
+}
+
+inline double json_number_value(const json_t* j) {
+	if (!j)
+		return 0.0;
+	if (j->type == json_t::INTEGER)
+		return (double) j->i;
+	if (j->type == json_t::REAL)
+		return j->r;
+	return 0.0;
+}
+
+inline json_t* json_string(const char* value) {
+	json_t* j = new json_t;
+	j->type = json_t::STRING;
+	j->s = value;
+	return j;
+}
+
+inline const char* json_string_value(const json_t* j) {
+	return (j && j->type == json_t::STRING) ? j->s.c_str() : NULL;
+}
+
+inline void json_decref(json_t* j) {
+	delete j;
+}
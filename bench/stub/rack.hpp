@@ -0,0 +1,1142 @@
+//
+//  rack.hpp (bench stub)
+//
+//  Minimal stand-in for the VCV Rack v2 SDK headers, only what the NANO modules use.
+//  Lets the module sources compile and run headless for benchmarks and golden renders.
+//  Widgets are inert, only the engine side (ports, params, lights, expanders) is real.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <pmmintrin.h>
+
+#include "jansson.h"
+
+namespace rack {
+
+/** Plugin-wide constants */
+static const float RACK_GRID_WIDTH = 15.f;
+static const float RACK_GRID_HEIGHT = 380.f;
+
+#define ENUMS(name, count) name, name##_LAST = name + (count) - 1
+#define LENGTHOF(arr) (sizeof(arr) / sizeof((arr)[0]))
+
+namespace string {
+inline std::string f(const char* format, ...) {
+	va_list args;
+	va_start(args, format);
+	char buf[1024];
+	vsnprintf(buf, sizeof(buf), format, args);
+	va_end(args);
+	return buf;
+}
+} // namespace string
+
+namespace math {
+
+inline int clamp(int x, int a, int b) {
+	return std::max(std::min(x, b), a);
+}
+
+inline float clamp(float x, float a = 0.f, float b = 1.f) {
+	return std::fmax(std::fmin(x, b), a);
+}
+
+inline float rescale(float x, float xMin, float xMax, float yMin, float yMax) {
+	return yMin + (x - xMin) / (xMax - xMin) * (yMax - yMin);
+}
+
+inline float crossfade(float a, float b, float p) {
+	return a + (b - a) * p;
+}
+
+inline float interpolateLinear(const float* p, float x) {
+	int xi = x;
+	float xf = x - xi;
+	return crossfade(p[xi], p[xi + 1], xf);
+}
+
+struct Vec {
+	float x = 0.f;
+	float y = 0.f;
+	Vec() {}
+	Vec(float xy) : x(xy), y(xy) {}
+	Vec(float x, float y) : x(x), y(y) {}
+	Vec plus(Vec b) const {
+		return Vec(x + b.x, y + b.y);
+	}
+	Vec minus(Vec b) const {
+		return Vec(x - b.x, y - b.y);
+	}
+	Vec mult(float s) const {
+		return Vec(x * s, y * s);
+	}
+	Vec div(float s) const {
+		return Vec(x / s, y / s);
+	}
+};
+
+struct Rect {
+	Vec pos;
+	Vec size;
+};
+
+} // namespace math
+
+using namespace math;
+
+inline math::Vec mm2px(math::Vec mm) {
+	return mm.mult(75.f / 25.4f);
+}
+
+namespace simd {
+
+template <typename T, int N>
+struct Vector;
+
+/** 4-lane SSE float vector, same layout and operators as `rack::simd::float_4`. */
+template <>
+struct Vector<float, 4> {
+	using type = float;
+	constexpr static int size = 4;
+
+	union {
+		__m128 v;
+		float s[4];
+	};
+
+	Vector() = default;
+	Vector(__m128 v) : v(v) {}
+	Vector(float x) {
+		v = _mm_set1_ps(x);
+	}
+	Vector(float x1, float x2, float x3, float x4) {
+		v = _mm_setr_ps(x1, x2, x3, x4);
+	}
+	inline Vector(Vector<int32_t, 4> a);
+
+	static Vector zero() {
+		return Vector(_mm_setzero_ps());
+	}
+	static Vector mask() {
+		return Vector(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_setzero_si128(), _mm_setzero_si128())));
+	}
+	static Vector load(const float* x) {
+		return Vector(_mm_loadu_ps(x));
+	}
+	void store(float* x) {
+		_mm_storeu_ps(x, v);
+	}
+	inline static Vector cast(Vector<int32_t, 4> a);
+
+	float& operator[](int i) {
+		return s[i];
+	}
+	const float& operator[](int i) const {
+		return s[i];
+	}
+};
+
+template <>
+struct Vector<int32_t, 4> {
+	using type = int32_t;
+	constexpr static int size = 4;
+
+	union {
+		__m128i v;
+		int32_t s[4];
+	};
+
+	Vector() = default;
+	Vector(__m128i v) : v(v) {}
+	Vector(int32_t x) {
+		v = _mm_set1_epi32(x);
+	}
+	Vector(int32_t x1, int32_t x2, int32_t x3, int32_t x4) {
+		v = _mm_setr_epi32(x1, x2, x3, x4);
+	}
+	Vector(Vector<float, 4> a) {
+		v = _mm_cvttps_epi32(a.v);
+	}
+
+	static Vector zero() {
+		return Vector(_mm_setzero_si128());
+	}
+	static Vector load(const int32_t* x) {
+		return Vector(_mm_loadu_si128((const __m128i*) x));
+	}
+	void store(int32_t* x) {
+		_mm_storeu_si128((__m128i*) x, v);
+	}
+	static Vector cast(Vector<float, 4> a) {
+		return Vector(_mm_castps_si128(a.v));
+	}
+
+	int32_t& operator[](int i) {
+		return s[i];
+	}
+	const int32_t& operator[](int i) const {
+		return s[i];
+	}
+};
+
+inline Vector<float, 4>::Vector(Vector<int32_t, 4> a) {
+	v = _mm_cvtepi32_ps(a.v);
+}
+
+inline Vector<float, 4> Vector<float, 4>::cast(Vector<int32_t, 4> a) {
+	return Vector(_mm_castsi128_ps(a.v));
+}
+
+typedef Vector<float, 4> float_4;
+typedef Vector<int32_t, 4> int32_4;
+
+#define STUB_FLOAT4_BINOP(op, fn) \
+	inline float_4 operator op(const float_4& a, const float_4& b) { return float_4(fn(a.v, b.v)); } \
+	inline float_4& operator op##=(float_4& a, const float_4& b) { return a = a op b; }
+
+STUB_FLOAT4_BINOP(+, _mm_add_ps)
+STUB_FLOAT4_BINOP(-, _mm_sub_ps)
+STUB_FLOAT4_BINOP(*, _mm_mul_ps)
+STUB_FLOAT4_BINOP(/, _mm_div_ps)
+STUB_FLOAT4_BINOP(&, _mm_and_ps)
+STUB_FLOAT4_BINOP(|, _mm_or_ps)
+STUB_FLOAT4_BINOP(^, _mm_xor_ps)
+#undef STUB_FLOAT4_BINOP
+
+inline float_4 operator==(const float_4& a, const float_4& b) { return float_4(_mm_cmpeq_ps(a.v, b.v)); }
+inline float_4 operator!=(const float_4& a, const float_4& b) { return float_4(_mm_cmpneq_ps(a.v, b.v)); }
+inline float_4 operator<(const float_4& a, const float_4& b) { return float_4(_mm_cmplt_ps(a.v, b.v)); }
+inline float_4 operator<=(const float_4& a, const float_4& b) { return float_4(_mm_cmple_ps(a.v, b.v)); }
+inline float_4 operator>(const float_4& a, const float_4& b) { return float_4(_mm_cmpgt_ps(a.v, b.v)); }
+inline float_4 operator>=(const float_4& a, const float_4& b) { return float_4(_mm_cmpge_ps(a.v, b.v)); }
+inline float_4 operator-(const float_4& a) { return 0.f - a; }
+inline float_4 operator~(const float_4& a) { return a ^ float_4::mask(); }
+
+inline int32_4 operator+(const int32_4& a, const int32_4& b) { return int32_4(_mm_add_epi32(a.v, b.v)); }
+inline int32_4 operator-(const int32_4& a, const int32_4& b) { return int32_4(_mm_sub_epi32(a.v, b.v)); }
+inline int32_4 operator&(const int32_4& a, const int32_4& b) { return int32_4(_mm_and_si128(a.v, b.v)); }
+inline int32_4 operator|(const int32_4& a, const int32_4& b) { return int32_4(_mm_or_si128(a.v, b.v)); }
+inline int32_4 operator^(const int32_4& a, const int32_4& b) { return int32_4(_mm_xor_si128(a.v, b.v)); }
+inline int32_4 operator<<(const int32_4& a, const int& b) { return int32_4(_mm_sll_epi32(a.v, _mm_cvtsi32_si128(b))); }
+inline int32_4 operator>>(const int32_4& a, const int& b) { return int32_4(_mm_sra_epi32(a.v, _mm_cvtsi32_si128(b))); }
+
+inline float_4 ifelse(float_4 mask, float_4 a, float_4 b) {
+	return (mask & a) | float_4(_mm_andnot_ps(mask.v, b.v));
+}
+inline float ifelse(bool mask, float a, float b) {
+	return mask ? a : b;
+}
+inline int movemask(float_4 a) {
+	return _mm_movemask_ps(a.v);
+}
+inline int movemask(bool a) {
+	return a ? 1 : 0;
+}
+
+// Scalar fallbacks so templated DSP code can be written once for float and float_4
+inline float fmin(float a, float b) { return std::fmin(a, b); }
+inline float fmax(float a, float b) { return std::fmax(a, b); }
+inline float clamp(float x, float a = 0.f, float b = 1.f) { return std::fmax(std::fmin(x, b), a); }
+inline float abs(float x) { return std::fabs(x); }
+inline float floor(float x) { return std::floor(x); }
+inline float trunc(float x) { return std::trunc(x); }
+inline float round(float x) { return std::round(x); }
+inline float sqrt(float x) { return std::sqrt(x); }
+inline float sin(float x) { return std::sin(x); }
+inline float cos(float x) { return std::cos(x); }
+inline float exp(float x) { return std::exp(x); }
+inline float log(float x) { return std::log(x); }
+inline float pow(float a, float b) { return std::pow(a, b); }
+inline float tanh(float x) { return std::tanh(x); }
+inline float sgn(float x) { return x > 0.f ? 1.f : (x < 0.f ? -1.f : 0.f); }
+
+inline float_4 fmin(float_4 a, float_4 b) { return float_4(_mm_min_ps(a.v, b.v)); }
+inline float_4 fmax(float_4 a, float_4 b) { return float_4(_mm_max_ps(a.v, b.v)); }
+inline float_4 clamp(float_4 x, float_4 a = 0.f, float_4 b = 1.f) { return fmin(fmax(x, a), b); }
+inline float_4 abs(float_4 x) { return float_4(_mm_andnot_ps(_mm_set1_ps(-0.f), x.v)); }
+inline float_4 sqrt(float_4 x) { return float_4(_mm_sqrt_ps(x.v)); }
+inline float_4 trunc(float_4 a) { return float_4(int32_4(a)); }
+inline float_4 floor(float_4 a) {
+	float_4 b = trunc(a);
+	return b - ifelse(a < b, 1.f, 0.f);
+}
+inline float_4 round(float_4 a) {
+	return floor(a + 0.5f);
+}
+inline float_4 sgn(float_4 x) {
+	return ifelse(x > 0.f, 1.f, ifelse(x < 0.f, -1.f, 0.f));
+}
+
+#define STUB_FLOAT4_LIBM(name) \
+	inline float_4 name(float_4 x) { return float_4(std::name(x[0]), std::name(x[1]), std::name(x[2]), std::name(x[3])); }
+STUB_FLOAT4_LIBM(sin)
+STUB_FLOAT4_LIBM(cos)
+STUB_FLOAT4_LIBM(exp)
+STUB_FLOAT4_LIBM(log)
+STUB_FLOAT4_LIBM(tanh)
+#undef STUB_FLOAT4_LIBM
+
+inline float_4 pow(float_4 a, float_4 b) {
+	return float_4(std::pow(a[0], b[0]), std::pow(a[1], b[1]), std::pow(a[2], b[2]), std::pow(a[3], b[3]));
+}
+inline float_4 pow(float a, float_4 b) {
+	return pow(float_4(a), b);
+}
+
+inline float_4 crossfade(float_4 a, float_4 b, float_4 p) {
+	return a + (b - a) * p;
+}
+inline float_4 rescale(float_4 x, float_4 xMin, float_4 xMax, float_4 yMin, float_4 yMax) {
+	return yMin + (x - xMin) / (xMax - xMin) * (yMax - yMin);
+}
+
+} // namespace simd
+
+namespace random {
+inline std::mt19937& stubGenerator() {
+	static thread_local std::mt19937 gen(0x4e414e4f);
+	return gen;
+}
+inline void seed(uint32_t s) {
+	stubGenerator().seed(s);
+}
+inline uint32_t u32() {
+	return stubGenerator()();
+}
+inline float uniform() {
+	return (u32() >> 8) * (1.f / 16777216.f);
+}
+inline float normal() {
+	static thread_local std::normal_distribution<float> dist;
+	return dist(stubGenerator());
+}
+} // namespace random
+
+namespace dsp {
+
+/** Detects rising edges with hysteresis, like `rack::dsp::TSchmittTrigger<float>`. */
+struct SchmittTrigger {
+	bool state = true;
+	void reset() {
+		state = true;
+	}
+	bool process(float in, float lowThreshold = 0.f, float highThreshold = 1.f) {
+		if (state) {
+			if (in <= lowThreshold)
+				state = false;
+		}
+		else if (in >= highThreshold) {
+			state = true;
+			return true;
+		}
+		return false;
+	}
+	bool isHigh() {
+		return state;
+	}
+};
+
+/** Counts calls and fires every `division` of them, like `rack::dsp::ClockDivider`. */
+struct ClockDivider {
+	uint32_t clock = 0;
+	uint32_t division = 1;
+	void reset() {
+		clock = 0;
+	}
+	void setDivision(uint32_t d) {
+		division = d;
+	}
+	uint32_t getDivision() {
+		return division;
+	}
+	uint32_t getClock() {
+		return clock;
+	}
+	bool process() {
+		clock++;
+		if (clock >= division) {
+			clock = 0;
+			return true;
+		}
+		return false;
+	}
+};
+
+struct PulseGenerator {
+	float remaining = 0.f;
+	void reset() {
+		remaining = 0.f;
+	}
+	bool process(float deltaTime) {
+		if (remaining > 0.f) {
+			remaining -= deltaTime;
+			return true;
+		}
+		return false;
+	}
+	void trigger(float duration = 1e-3f) {
+		if (duration > remaining)
+			remaining = duration;
+	}
+};
+
+inline float amplitudeToDb(float amp) {
+	return std::log10(amp) * 20.f;
+}
+inline float dbToAmplitude(float db) {
+	return std::pow(10.f, db / 20.f);
+}
+
+/** Fills `output` with the 2 * z * o points of a minimum-phase band-limited step, like `rack::dsp::minBlepImpulse`. */
+void minBlepImpulse(int z, int o, float* output);
+
+/** Band-limited step residuals summed into a ring buffer, like `rack::dsp::MinBlepGenerator`. */
+template <int Z, int O, typename T = float>
+struct MinBlepGenerator {
+	T buf[2 * Z] = {};
+	int pos = 0;
+	float impulse[2 * Z * O + 1];
+
+	MinBlepGenerator() {
+		minBlepImpulse(Z, O, impulse);
+		impulse[2 * Z * O] = 1.f;
+	}
+
+	/** Places a discontinuity with magnitude `x` at -1 < p <= 0 relative to the current frame */
+	void insertDiscontinuity(float p, T x) {
+		if (!(-1 < p && p <= 0))
+			return;
+		for (int j = 0; j < 2 * Z; j++) {
+			float minBlepIndex = ((float) j - p) * O;
+			int index = (int) minBlepIndex;
+			float indexFrac = minBlepIndex - index;
+			float minBlep = math::crossfade(impulse[index], impulse[index + 1], indexFrac);
+			buf[(pos + j) % (2 * Z)] += x * (minBlep - 1.f);
+		}
+	}
+
+	T process() {
+		T v = buf[pos];
+		buf[pos] = T(0);
+		pos = (pos + 1) % (2 * Z);
+		return v;
+	}
+};
+
+} // namespace dsp
+
+/** Base of the values a slider or a knob edits, like `rack::Quantity`. */
+struct Quantity {
+	virtual ~Quantity() {}
+};
+
+namespace engine {
+
+static const int PORT_MAX_CHANNELS = 16;
+
+struct Module;
+
+struct Param {
+	float value = 0.f;
+	float getValue() {
+		return value;
+	}
+	void setValue(float value) {
+		this->value = value;
+	}
+};
+
+struct ParamQuantity : Quantity {
+	Module* module = NULL;
+	int paramId = -1;
+	float minValue = 0.f;
+	float maxValue = 1.f;
+	float defaultValue = 0.f;
+	std::string name;
+	std::string unit;
+	bool snapEnabled = false;
+	bool randomizeEnabled = true;
+	std::vector<std::string> labels;
+	virtual ~ParamQuantity() {}
+	inline void setValue(float value);
+	inline float getValue();
+};
+
+struct SwitchQuantity : ParamQuantity {};
+
+struct PortInfo {
+	std::string name;
+	std::string description;
+};
+
+struct Port {
+	union {
+		float voltages[PORT_MAX_CHANNELS] = {};
+		float value;
+	};
+	uint8_t channels = 0;
+
+	void setVoltage(float voltage, int channel = 0) {
+		voltages[channel] = voltage;
+	}
+	float getVoltage(int channel = 0) {
+		return voltages[channel];
+	}
+	float getPolyVoltage(int channel) {
+		return isMonophonic() ? getVoltage(0) : getVoltage(channel);
+	}
+	float getNormalVoltage(float normalVoltage, int channel = 0) {
+		return isConnected() ? getVoltage(channel) : normalVoltage;
+	}
+	float getNormalPolyVoltage(float normalVoltage, int channel) {
+		return isConnected() ? getPolyVoltage(channel) : normalVoltage;
+	}
+	float* getVoltages(int firstChannel = 0) {
+		return &voltages[firstChannel];
+	}
+	void readVoltages(float* v) {
+		for (int c = 0; c < channels; c++)
+			v[c] = voltages[c];
+	}
+	void writeVoltages(const float* v) {
+		for (int c = 0; c < channels; c++)
+			voltages[c] = v[c];
+	}
+	void clearVoltages() {
+		for (int c = 0; c < channels; c++)
+			voltages[c] = 0.f;
+	}
+	float getVoltageSum() {
+		float sum = 0.f;
+		for (int c = 0; c < channels; c++)
+			sum += voltages[c];
+		return sum;
+	}
+	template <typename T>
+	T getVoltageSimd(int firstChannel) {
+		return T::load(&voltages[firstChannel]);
+	}
+	template <typename T>
+	T getPolyVoltageSimd(int firstChannel) {
+		return isMonophonic() ? getVoltage(0) : getVoltageSimd<T>(firstChannel);
+	}
+	template <typename T>
+	void setVoltageSimd(T voltage, int firstChannel) {
+		voltage.store(&voltages[firstChannel]);
+	}
+	void setChannels(int channels) {
+		// Mirrors Rack: a disconnected output stays disconnected
+		if (this->channels == 0)
+			return;
+		if (channels == 0)
+			channels = 1;
+		for (int c = channels; c < this->channels; c++)
+			voltages[c] = 0.f;
+		this->channels = channels;
+	}
+	int getChannels() {
+		return channels;
+	}
+	bool isConnected() {
+		return channels > 0;
+	}
+	bool isMonophonic() {
+		return channels == 1;
+	}
+	bool isPolyphonic() {
+		return channels > 1;
+	}
+};
+
+struct Output : Port {};
+struct Input : Port {};
+
+struct Light {
+	float value = 0.f;
+	void setBrightness(float brightness) {
+		value = brightness;
+	}
+	float getBrightness() {
+		return value;
+	}
+	void setBrightnessSmooth(float brightness, float deltaTime, float lambda = 30.f) {
+		if (brightness < value)
+			value += (brightness - value) * lambda * deltaTime;
+		else
+			value = brightness;
+	}
+	void setSmoothBrightness(float brightness, float deltaTime) {
+		setBrightnessSmooth(brightness, deltaTime);
+	}
+};
+
+} // namespace engine
+
+namespace plugin {
+struct Model;
+}
+
+namespace engine {
+
+struct Module {
+	plugin::Model* model = NULL;
+	int64_t id = -1;
+
+	std::vector<Param> params;
+	std::vector<Input> inputs;
+	std::vector<Output> outputs;
+	std::vector<Light> lights;
+	std::vector<ParamQuantity*> paramQuantities;
+	std::vector<PortInfo*> inputInfos;
+	std::vector<PortInfo*> outputInfos;
+
+	struct Expander {
+		int64_t moduleId = -1;
+		Module* module = NULL;
+		void* producerMessage = NULL;
+		void* consumerMessage = NULL;
+		bool messageFlipRequested = false;
+		void requestMessageFlip() {
+			messageFlipRequested = true;
+		}
+	};
+	Expander leftExpander;
+	Expander rightExpander;
+
+	struct ProcessArgs {
+		float sampleRate;
+		float sampleTime;
+		int64_t frame;
+	};
+
+	struct SampleRateChangeEvent {
+		float sampleRate;
+		float sampleTime;
+	};
+
+	Module() {}
+	virtual ~Module() {
+		for (ParamQuantity* pq : paramQuantities)
+			delete pq;
+		for (PortInfo* pi : inputInfos)
+			delete pi;
+		for (PortInfo* pi : outputInfos)
+			delete pi;
+	}
+
+	void config(int numParams, int numInputs, int numOutputs, int numLights = 0) {
+		params.resize(numParams);
+		inputs.resize(numInputs);
+		outputs.resize(numOutputs);
+		lights.resize(numLights);
+		paramQuantities.resize(numParams, NULL);
+		inputInfos.resize(numInputs, NULL);
+		outputInfos.resize(numOutputs, NULL);
+	}
+
+	template <class TParamQuantity = ParamQuantity>
+	TParamQuantity* configParam(int paramId, float minValue, float maxValue, float defaultValue, std::string name = "", std::string unit = "", float displayBase = 0.f, float displayMultiplier = 1.f, float displayOffset = 0.f) {
+		delete paramQuantities[paramId];
+		TParamQuantity* q = new TParamQuantity;
+		q->module = this;
+		q->paramId = paramId;
+		q->minValue = minValue;
+		q->maxValue = maxValue;
+		q->defaultValue = defaultValue;
+		q->name = name;
+		q->unit = unit;
+		paramQuantities[paramId] = q;
+		params[paramId].value = defaultValue;
+		return q;
+	}
+
+	template <class TSwitchQuantity = SwitchQuantity>
+	TSwitchQuantity* configSwitch(int paramId, float minValue, float maxValue, float defaultValue, std::string name = "", std::vector<std::string> labels = {}) {
+		TSwitchQuantity* sq = configParam<TSwitchQuantity>(paramId, minValue, maxValue, defaultValue, name);
+		sq->snapEnabled = true;
+		sq->labels = labels;
+		return sq;
+	}
+
+	template <class TSwitchQuantity = SwitchQuantity>
+	TSwitchQuantity* configButton(int paramId, std::string name = "") {
+		TSwitchQuantity* sq = configParam<TSwitchQuantity>(paramId, 0.f, 1.f, 0.f, name);
+		sq->randomizeEnabled = false;
+		return sq;
+	}
+
+	PortInfo* configInput(int portId, std::string name = "") {
+		delete inputInfos[portId];
+		PortInfo* info = new PortInfo;
+		info->name = name;
+		inputInfos[portId] = info;
+		return info;
+	}
+
+	PortInfo* configOutput(int portId, std::string name = "") {
+		delete outputInfos[portId];
+		PortInfo* info = new PortInfo;
+		info->name = name;
+		outputInfos[portId] = info;
+		return info;
+	}
+
+	virtual void process(const ProcessArgs& args) {}
+	virtual json_t* dataToJson() {
+		return NULL;
+	}
+	virtual void dataFromJson(json_t* rootJ) {}
+	virtual void onSampleRateChange() {}
+	virtual void onSampleRateChange(const SampleRateChangeEvent& e) {
+		onSampleRateChange();
+	}
+	virtual void onReset() {}
+};
+
+inline void ParamQuantity::setValue(float value) {
+	module->params[paramId].setValue(value);
+}
+inline float ParamQuantity::getValue() {
+	return module->params[paramId].getValue();
+}
+
+/** Only the engine queries the modules make outside of `process()`. */
+struct Engine {
+	float sampleRate = 44100.f;
+	float getSampleRate() {
+		return sampleRate;
+	}
+	float getSampleTime() {
+		return 1.f / sampleRate;
+	}
+};
+
+} // namespace engine
+
+namespace window {
+
+struct Svg {
+	static std::shared_ptr<Svg> load(const std::string& filename) {
+		return std::make_shared<Svg>();
+	}
+};
+
+struct Window {
+	std::shared_ptr<Svg> loadSvg(const std::string& filename) {
+		return Svg::load(filename);
+	}
+};
+
+} // namespace window
+
+namespace widget {
+
+/** Widgets never draw in the stub, they only own their children so nothing leaks. */
+struct Widget {
+	math::Rect box;
+	Widget* parent = NULL;
+	std::list<Widget*> children;
+	bool visible = true;
+
+	virtual ~Widget() {
+		for (Widget* child : children)
+			delete child;
+	}
+	void addChild(Widget* child) {
+		child->parent = this;
+		children.push_back(child);
+	}
+	void addChildBelow(Widget* child, Widget* sibling) {
+		addChild(child);
+	}
+	void addChildBottom(Widget* child) {
+		addChild(child);
+	}
+	void hide() {
+		visible = false;
+	}
+	void show() {
+		visible = true;
+	}
+};
+
+struct SvgWidget : Widget {
+	std::shared_ptr<window::Svg> svg;
+	void setSvg(std::shared_ptr<window::Svg> svg) {
+		this->svg = svg;
+	}
+};
+
+struct FramebufferWidget : Widget {};
+struct TransformWidget : Widget {};
+
+} // namespace widget
+
+namespace event {
+struct Action {};
+} // namespace event
+
+namespace ui {
+
+struct Menu;
+
+struct MenuItem : widget::Widget {
+	std::string text;
+	std::string rightText;
+	bool disabled = false;
+	virtual void onAction(const event::Action& e) {}
+	/** Submenu items build their menu when opened, the caller owns it. */
+	virtual Menu* createChildMenu() {
+		return NULL;
+	}
+};
+
+struct MenuLabel : MenuItem {};
+struct MenuSeparator : widget::Widget {};
+struct Menu : widget::Widget {};
+struct Slider : widget::Widget {
+	Quantity* quantity = NULL;
+};
+
+} // namespace ui
+
+namespace engine {
+struct Engine;
+}
+
+struct Context {
+	engine::Engine* engine = NULL;
+	window::Window* window = NULL;
+};
+
+Context* contextGet();
+
+#define APP rack::contextGet()
+
+namespace plugin {
+struct Plugin;
+}
+
+namespace asset {
+inline std::string system(std::string filename) {
+	return filename;
+}
+inline std::string plugin(plugin::Plugin* plugin, std::string filename) {
+	return filename;
+}
+} // namespace asset
+
+namespace app {
+
+struct ModuleWidget;
+
+struct ParamWidget : widget::Widget {
+	engine::Module* module = NULL;
+	int paramId = -1;
+};
+
+struct PortWidget : widget::Widget {
+	engine::Module* module = NULL;
+	int portId = -1;
+	bool output = false;
+};
+
+struct LightWidget : widget::Widget {
+	engine::Module* module = NULL;
+	int firstLightId = -1;
+};
+
+struct ModuleLightWidget : LightWidget {
+	std::vector<int> baseColors;
+	void addBaseColor(int color) {
+		baseColors.push_back(color);
+	}
+};
+
+struct SvgPort : PortWidget {
+	void setSvg(std::shared_ptr<window::Svg> svg) {}
+};
+
+struct SvgSwitch : ParamWidget {
+	std::vector<std::shared_ptr<window::Svg>> frames;
+	bool momentary = false;
+	void addFrame(std::shared_ptr<window::Svg> svg) {
+		frames.push_back(svg);
+	}
+};
+
+struct SvgKnob : ParamWidget {
+	widget::FramebufferWidget* fb;
+	widget::TransformWidget* tw;
+	widget::SvgWidget* sw;
+	float minAngle = -M_PI;
+	float maxAngle = M_PI;
+	bool snap = false;
+	SvgKnob() {
+		fb = new widget::FramebufferWidget;
+		addChild(fb);
+		tw = new widget::TransformWidget;
+		fb->addChild(tw);
+		sw = new widget::SvgWidget;
+		tw->addChild(sw);
+	}
+	void setSvg(std::shared_ptr<window::Svg> svg) {
+		sw->setSvg(svg);
+	}
+};
+
+struct SvgSlider : ParamWidget {};
+struct SvgScrew : widget::Widget {};
+struct SvgPanel : widget::Widget {};
+
+struct ModuleWidget : widget::Widget {
+	plugin::Model* model = NULL;
+	engine::Module* module = NULL;
+
+	void setModel(plugin::Model* model) {
+		this->model = model;
+	}
+	void setModule(engine::Module* module) {
+		this->module = module;
+	}
+	engine::Module* getModule() {
+		return module;
+	}
+	void setPanel(std::shared_ptr<window::Svg> svg) {}
+	void setPanel(widget::Widget* panel) {
+		addChild(panel);
+	}
+	void addParam(ParamWidget* param) {
+		addChild(param);
+	}
+	void addInput(PortWidget* input) {
+		addChild(input);
+	}
+	void addOutput(PortWidget* output) {
+		addChild(output);
+	}
+	virtual void appendContextMenu(ui::Menu* menu) {}
+};
+
+} // namespace app
+
+namespace plugin {
+
+struct Model {
+	Plugin* plugin = NULL;
+	std::string slug;
+	std::string name;
+	virtual ~Model() {}
+	virtual engine::Module* createModule() {
+		return NULL;
+	}
+	virtual app::ModuleWidget* createModuleWidget(engine::Module* m) {
+		return NULL;
+	}
+};
+
+struct Plugin {
+	std::list<Model*> models;
+	std::string slug = "NANOModules";
+	void addModel(Model* model) {
+		model->plugin = this;
+		models.push_back(model);
+	}
+	Model* getModel(const std::string& slug) {
+		for (Model* model : models)
+			if (model->slug == slug)
+				return model;
+		return NULL;
+	}
+};
+
+} // namespace plugin
+
+using namespace engine;
+using namespace widget;
+using namespace ui;
+using namespace app;
+using plugin::Model;
+using plugin::Plugin;
+using window::Svg;
+
+template <class TModule, class TModuleWidget>
+plugin::Model* createModel(std::string slug) {
+	struct TModel : plugin::Model {
+		engine::Module* createModule() override {
+			engine::Module* m = new TModule;
+			m->model = this;
+			return m;
+		}
+		app::ModuleWidget* createModuleWidget(engine::Module* m) override {
+			TModule* tm = dynamic_cast<TModule*>(m);
+			TModuleWidget* mw = new TModuleWidget(tm);
+			mw->setModel(this);
+			return mw;
+		}
+	};
+	plugin::Model* o = new TModel;
+	o->slug = slug;
+	return o;
+}
+
+template <class TWidget>
+TWidget* createWidget(math::Vec pos) {
+	TWidget* o = new TWidget;
+	o->box.pos = pos;
+	return o;
+}
+
+template <class TWidget>
+TWidget* createWidgetCentered(math::Vec pos) {
+	return createWidget<TWidget>(pos);
+}
+
+template <class TParamWidget>
+TParamWidget* createParam(math::Vec pos, engine::Module* module, int paramId) {
+	TParamWidget* o = new TParamWidget;
+	o->box.pos = pos;
+	o->module = module;
+	o->paramId = paramId;
+	return o;
+}
+
+template <class TParamWidget>
+TParamWidget* createParamCentered(math::Vec pos, engine::Module* module, int paramId) {
+	return createParam<TParamWidget>(pos, module, paramId);
+}
+
+template <class TPortWidget>
+TPortWidget* createInput(math::Vec pos, engine::Module* module, int inputId) {
+	TPortWidget* o = new TPortWidget;
+	o->box.pos = pos;
+	o->module = module;
+	o->portId = inputId;
+	return o;
+}
+
+template <class TPortWidget>
+TPortWidget* createInputCentered(math::Vec pos, engine::Module* module, int inputId) {
+	return createInput<TPortWidget>(pos, module, inputId);
+}
+
+template <class TPortWidget>
+TPortWidget* createOutput(math::Vec pos, engine::Module* module, int outputId) {
+	TPortWidget* o = createInput<TPortWidget>(pos, module, outputId);
+	o->output = true;
+	return o;
+}
+
+template <class TPortWidget>
+TPortWidget* createOutputCentered(math::Vec pos, engine::Module* module, int outputId) {
+	return createOutput<TPortWidget>(pos, module, outputId);
+}
+
+template <class TModuleLightWidget>
+TModuleLightWidget* createLight(math::Vec pos, engine::Module* module, int firstLightId) {
+	TModuleLightWidget* o = new TModuleLightWidget;
+	o->box.pos = pos;
+	o->module = module;
+	o->firstLightId = firstLightId;
+	return o;
+}
+
+template <class TModuleLightWidget>
+TModuleLightWidget* createLightCentered(math::Vec pos, engine::Module* module, int firstLightId) {
+	return createLight<TModuleLightWidget>(pos, module, firstLightId);
+}
+
+template <class TParamWidget>
+TParamWidget* createLightParam(math::Vec pos, engine::Module* module, int paramId, int firstLightId) {
+	TParamWidget* o = createParam<TParamWidget>(pos, module, paramId);
+	o->getLight()->module = module;
+	o->getLight()->firstLightId = firstLightId;
+	return o;
+}
+
+template <class TParamWidget>
+TParamWidget* createLightParamCentered(math::Vec pos, engine::Module* module, int paramId, int firstLightId) {
+	return createLightParam<TParamWidget>(pos, module, paramId, firstLightId);
+}
+
+template <class TMenuLabel = ui::MenuLabel>
+TMenuLabel* createMenuLabel(std::string text) {
+	TMenuLabel* o = new TMenuLabel;
+	o->text = text;
+	return o;
+}
+
+template <class TMenuItem = ui::MenuItem>
+TMenuItem* createMenuItem(std::string text, std::string rightText = "", std::function<void()> action = []() {}, bool disabled = false) {
+	struct Item : TMenuItem {
+		std::function<void()> action;
+		void onAction(const event::Action& e) override {
+			action();
+		}
+	};
+	Item* item = new Item;
+	item->text = text;
+	item->rightText = rightText;
+	item->action = action;
+	item->disabled = disabled;
+	return item;
+}
+
+template <class TMenuItem = ui::MenuItem>
+TMenuItem* createBoolMenuItem(std::string text, std::string rightText, std::function<bool()> getter, std::function<void(bool state)> setter, bool disabled = false) {
+	return createMenuItem<TMenuItem>(text, getter() ? "✔" : rightText, [=]() { setter(!getter()); }, disabled);
+}
+
+template <typename T>
+ui::MenuItem* createBoolPtrMenuItem(std::string text, std::string rightText, T* ptr) {
+	return createBoolMenuItem(text, rightText, [=]() { return ptr ? *ptr : false; }, [=](T val) { if (ptr) *ptr = val; });
+}
+
+inline ui::MenuItem* createSubmenuItem(std::string text, std::string rightText, std::function<void(ui::Menu* menu)> createMenu, bool disabled = false) {
+	struct Item : ui::MenuItem {
+		std::function<void(ui::Menu* menu)> createMenu;
+		ui::Menu* createChildMenu() override {
+			ui::Menu* menu = new ui::Menu;
+			createMenu(menu);
+			return menu;
+		}
+	};
+	Item* item = new Item;
+	item->text = text;
+	item->rightText = rightText;
+	item->createMenu = createMenu;
+	item->disabled = disabled;
+	return item;
+}
+
+inline ui::MenuItem* createIndexSubmenuItem(std::string text, std::vector<std::string> labels, std::function<size_t()> getter, std::function<void(size_t val)> setter, bool disabled = false) {
+	size_t index = getter();
+	return createSubmenuItem(text, index < labels.size() ? labels[index] : "", [=](ui::Menu* menu) {
+		for (size_t i = 0; i < labels.size(); i++)
+			menu->addChild(createMenuItem(labels[i], (getter() == i) ? "✔" : "", [=]() { setter(i); }));
+	}, disabled);
+}
+
+template <typename T>
+ui::MenuItem* createIndexPtrSubmenuItem(std::string text, std::vector<std::string> labels, T* ptr) {
+	return createIndexSubmenuItem(text, labels, [=]() { return ptr ? (size_t) *ptr : 0; }, [=](size_t index) { if (ptr) *ptr = T(index); });
+}
+
+} // namespace rack
+
+#include "componentlibrary.hpp"
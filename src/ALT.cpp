@@ -1,4 +1,5 @@
 #include "plugin.hpp"
+#include "NANOTiming.hpp"
 
 struct ALT : Module
 {
@@ -207,4 +208,4 @@ struct ALTWidget : ModuleWidget
     }
 };
 
-Model *modelALT = createModel<ALT, ALTWidget>("ALT");
\ No newline at end of file
+Model *modelALT = createModel<NANOTiming::Timed<ALT>, NANOTiming::TimedWidget<ALTWidget>>("ALT");
\ No newline at end of file
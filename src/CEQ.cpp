@@ -1,6 +1,7 @@
 #include "plugin.hpp"
 #include <componentlibrary.hpp>
 #include "NANOComponents.hpp"
+#include "NANOTiming.hpp"
 
 #include "Resources/DaisySP/Source/Filters/svf.h"
 #include "Resources/DaisySP/Source/Dynamics/compressor.h"
@@ -168,4 +169,4 @@ struct CEQWidget : ModuleWidget
     }
 };
 
-Model *modelCEQ = createModel<CEQ, CEQWidget>("CEQ");
\ No newline at end of file
+Model *modelCEQ = createModel<NANOTiming::Timed<CEQ>, NANOTiming::TimedWidget<CEQWidget>>("CEQ");
\ No newline at end of file
@@ -1,12 +1,21 @@
 #include "plugin.hpp"
 #include <componentlibrary.hpp>
 #include "NANOComponents.hpp"
+#include "NANOTiming.hpp"
 #include "PerformanceMixer.hpp"
 
+using simd::float_4;
+
 struct EXP4 : Module
 {       
-    float l_exp4[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
-    float r_exp4[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
+    // Post fader channels of the mixer, channel i in lane i
+    float_4 l_exp4 = 0.0f;
+    float_4 r_exp4 = 0.0f;
+
+    // Messages from the mixer, read one sample after it wrote them
+    ExpanderBuffers<MixerToExpanderMessage> fromMixer;
+    // Cascade bus from a mixer on the left, relayed to the mixer on the right
+    ExpanderBuffers<MixerBus> fromCascade;
 
     enum ParamIds
     {
@@ -20,6 +29,7 @@ struct EXP4 : Module
         MUTE_GATE_4,
         CV_AUX_3, 
         CV_AUX_4,             
+        MUTE_GATE_POLY,
         NUM_INPUTS
     };
     enum OutputIds
@@ -32,12 +42,15 @@ struct EXP4 : Module
         R2_OUTPUT,
         R3_OUTPUT, 
         R4_OUTPUT,
+        POLY_OUTPUT,
         NUM_OUTPUTS
     };
 
     EXP4()
     {
         config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS);
+        fromMixer.attach(rightExpander);
+        fromCascade.attach(leftExpander);
 
         configOutput(L1_OUTPUT, "L1");
         configOutput(R1_OUTPUT, "R1");
@@ -47,11 +60,13 @@ struct EXP4 : Module
         configOutput(R3_OUTPUT, "R3");
         configOutput(L4_OUTPUT, "L4");
         configOutput(R4_OUTPUT, "R4");
+        configOutput(POLY_OUTPUT, "Direct outs, poly L1 R1 L2 R2 L3 R3 L4 R4");
 
         configInput(MUTE_GATE_1, "Mute Gate 1");
         configInput(MUTE_GATE_2, "Mute Gate 2");
         configInput(MUTE_GATE_3, "Mute Gate 3");
         configInput(MUTE_GATE_4, "Mute Gate 4");
+        configInput(MUTE_GATE_POLY, "Mute Gates 1-4, poly, a mono cable mutes all channels");
 
         configInput(CV_AUX_3, "CV Aux 3");
         configInput(CV_AUX_4, "CV Aux 4");
@@ -63,27 +78,27 @@ struct EXP4 : Module
         bool mainModuleConnected = rightExpander.module && (rightExpander.module->model == modelPerformanceMixer);
 
         if (mainModuleConnected) {
-            // Access the shared data
-            SharedData* sharedData = (SharedData*) rightExpander.module->leftExpander.producerMessage;
-
-            if (sharedData) {
-                for(uint32_t i = 0; i < MIXER_CHANNELS; i++){
-                    // Read the shared data
-                    l_exp4[i] = sharedData->shared_l_output[i];
-                    r_exp4[i] = sharedData->shared_r_output[i];
-                    if(inputs[MUTE_GATE_1 + i].getVoltage() >= 2.0f){
-                        sharedData->shared_gateMuted[i] = true;
-                    } else {
-                        sharedData->shared_gateMuted[i] = false;
-                    }
-                }
-
-                sharedData->shared_cv_aux[2] = inputs[CV_AUX_3].getVoltage();
-                sharedData->shared_cv_aux[3] = inputs[CV_AUX_4].getVoltage();
-
-                // Do something with the value
-                // ...
+            // Read the channels the mixer sent on the last sample
+            const MixerToExpanderMessage *fromMain = (const MixerToExpanderMessage*) rightExpander.consumerMessage;
+            // Send the mute gates and aux CVs to the mixer
+            ToMixerMessage *toMain = (ToMixerMessage*) rightExpander.module->leftExpander.producerMessage;
+
+            l_exp4 = float_4::load(fromMain->l_output);
+            r_exp4 = float_4::load(fromMain->r_output);
+            // A channel mutes on its own gate or on its channel of the poly gate
+            int gateChannels = inputs[MUTE_GATE_POLY].getChannels();
+            for(uint32_t i = 0; i < MIXER_CHANNELS; i++){
+                float polyGate = ((int)i < gateChannels || gateChannels == 1) ? inputs[MUTE_GATE_POLY].getPolyVoltage(i) : 0.0f;
+                toMain->gateMuted[i] = inputs[MUTE_GATE_1 + i].getVoltage() >= 2.0f || polyGate >= 2.0f;
             }
+
+            toMain->cv_aux[2] = inputs[CV_AUX_3].getVoltage();
+            toMain->cv_aux[3] = inputs[CV_AUX_4].getVoltage();
+
+            // Relay the bus of a cascaded mixer on the left
+            bool cascaded = leftExpander.module && (leftExpander.module->model == modelPerformanceMixer);
+            toMain->bus = cascaded ? *(const MixerBus*) leftExpander.consumerMessage : MixerBus();
+            rightExpander.module->leftExpander.requestMessageFlip();
         }
     
         // Write voltage outputs
@@ -91,6 +106,13 @@ struct EXP4 : Module
             outputs[L1_OUTPUT + i].setVoltage(l_exp4[i]);
             outputs[R1_OUTPUT + i].setVoltage(r_exp4[i]);
         }
+
+        // All eight on one cable, the stereo pairs interleaved
+        if (outputs[POLY_OUTPUT].isConnected()) {
+            outputs[POLY_OUTPUT].setChannels(2 * MIXER_CHANNELS);
+            outputs[POLY_OUTPUT].setVoltageSimd(float_4(_mm_unpacklo_ps(l_exp4.v, r_exp4.v)), 0);
+            outputs[POLY_OUTPUT].setVoltageSimd(float_4(_mm_unpackhi_ps(l_exp4.v, r_exp4.v)), 4);
+        }
     }
 
 };
@@ -109,21 +131,23 @@ struct EXP4Widget : ModuleWidget
 
         addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(5 ,  14.50)), module, EXP4::L1_OUTPUT));
         addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(15,  14.50)), module, EXP4::R1_OUTPUT));
-        addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(5 ,  27.50)), module, EXP4::L2_OUTPUT));
-        addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(15,  27.50)), module, EXP4::R2_OUTPUT));
-        addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(5 ,  40.50)), module, EXP4::L3_OUTPUT));
-        addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(15,  40.50)), module, EXP4::R3_OUTPUT));
-        addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(5 ,  53.50)), module, EXP4::L4_OUTPUT));
-        addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(15,  53.50)), module, EXP4::R4_OUTPUT));
-
-        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(5 ,  75.00)), module, EXP4::MUTE_GATE_1));
-        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(15,  75.00)), module, EXP4::MUTE_GATE_2));
-        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(5 ,  88.00)), module, EXP4::MUTE_GATE_3));
-        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(15,  88.00)), module, EXP4::MUTE_GATE_4));
-
-        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(5 , 108.00)), module, EXP4::CV_AUX_3));
-        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(15, 108.00)), module, EXP4::CV_AUX_4));
+        addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(5 ,  27.00)), module, EXP4::L2_OUTPUT));
+        addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(15,  27.00)), module, EXP4::R2_OUTPUT));
+        addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(5 ,  39.50)), module, EXP4::L3_OUTPUT));
+        addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(15,  39.50)), module, EXP4::R3_OUTPUT));
+        addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(5 ,  52.00)), module, EXP4::L4_OUTPUT));
+        addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(15,  52.00)), module, EXP4::R4_OUTPUT));
+        addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(5 ,  65.25)), module, EXP4::POLY_OUTPUT));
+        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(15,  65.25)), module, EXP4::MUTE_GATE_POLY));
+
+        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(5 ,  82.00)), module, EXP4::MUTE_GATE_1));
+        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(15,  82.00)), module, EXP4::MUTE_GATE_2));
+        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(5 ,  95.00)), module, EXP4::MUTE_GATE_3));
+        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(15,  95.00)), module, EXP4::MUTE_GATE_4));
+
+        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(5 , 113.00)), module, EXP4::CV_AUX_3));
+        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(15, 113.00)), module, EXP4::CV_AUX_4));
     }
 };
 
-Model *modelEXP4 = createModel<EXP4, EXP4Widget>("EXP4");
\ No newline at end of file
+Model *modelEXP4 = createModel<NANOTiming::Timed<EXP4>, NANOTiming::TimedWidget<EXP4Widget>>("EXP4");
\ No newline at end of file
@@ -1,10 +1,14 @@
 #include "plugin.hpp"
+#include "NANOTiming.hpp"
+#include "Resources/SynthTools/lookupTables.hpp"
+#include "Resources/SynthTools/tableRegistry.hpp"
 
 struct FONT : Module
 {
 
     float firstStage = 0.f, secondStage = 0.f;
     float resonanceFactor = 1.0f;
+    std::shared_ptr<const TanhTable> saturation = TableRegistry::acquire<TanhTable>();
 
     enum ParamIds
     {
@@ -71,14 +75,14 @@ struct FONT : Module
             firstStage += 0.001f;
         }
 
-        firstStage += cutoff * (inputs[IN_INPUT].getVoltage() - firstStage + (resonance * (tanh((firstStage - secondStage) / 10.0f))));
+        firstStage += cutoff * (inputs[IN_INPUT].getVoltage() - firstStage + (resonance * (saturation->tanh((firstStage - secondStage) / 10.0f))));
         //firstStage = clamp(firstStage, -10.0f, 10.0f);
 
         secondStage += cutoff * (firstStage - secondStage + 0.1f);
         //secondStage = clamp(secondStage, -10.0f, 10.0f);
 
-        outputs[LPF_OUTPUT].setVoltage(tanh(secondStage / 10.0f) * 11.0f);
-        outputs[BPF_OUTPUT].setVoltage(tanh((firstStage - secondStage) / 10.0f) * 11.0f);
+        outputs[LPF_OUTPUT].setVoltage(saturation->tanh(secondStage / 10.0f) * 11.0f);
+        outputs[BPF_OUTPUT].setVoltage(saturation->tanh((firstStage - secondStage) / 10.0f) * 11.0f);
     }
 };
 
@@ -109,4 +113,4 @@ struct FONTWidget : ModuleWidget
     }
 };
 
-Model *modelFONT = createModel<FONT, FONTWidget>("FONT");
\ No newline at end of file
+Model *modelFONT = createModel<NANOTiming::Timed<FONT>, NANOTiming::TimedWidget<FONTWidget>>("FONT");
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "plugin.hpp"
+#include "NANOTiming.hpp"
 
 struct MAR : Module
 {
@@ -155,4 +156,4 @@ struct MARWidget : ModuleWidget
 	}
 };
 
-Model *modelMAR = createModel<MAR, MARWidget>("MAR");
\ No newline at end of file
+Model *modelMAR = createModel<NANOTiming::Timed<MAR>, NANOTiming::TimedWidget<MARWidget>>("MAR");
\ No newline at end of file
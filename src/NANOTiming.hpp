@@ -0,0 +1,235 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Live DSP cost of each module instance, shown in its context menu.
+// Models are registered as createModel<NANOTiming::Timed<MyModule>, NANOTiming::TimedWidget<MyModuleWidget>>.
+// Timing is off by default and switched on per instance from the menu, until then process() only
+// pays for one branch on top of the module's own work.
+namespace NANOTiming
+{
+    // Raw counter, TSC on x86, virtual counter on ARM64, steady clock elsewhere
+#if defined(__x86_64__) || defined(__i386__)
+    static const char *const COUNTER_UNIT = "cycles";
+#elif defined(__aarch64__)
+    static const char *const COUNTER_UNIT = "counter ticks";
+#else
+    static const char *const COUNTER_UNIT = "ns";
+#endif
+
+    inline uint64_t readCounter()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#elif defined(__aarch64__)
+        uint64_t t;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(t));
+        return t;
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // Accumulates per-sample costs on the audio thread and publishes mean, p99 and max once per window.
+    // p99 comes from a log histogram with 4 buckets per octave, so it is exact to within ~19%.
+    // Costs are counted in COUNTER_UNIT, which is cycles only on x86.
+    struct DSPTimer
+    {
+        static const int BUCKETS = 128;
+
+        uint32_t histogram[BUCKETS] = {};
+        uint64_t sum = 0;
+        uint32_t max = 0;
+        uint32_t count = 0;
+        uint32_t window = 44100;
+        uint64_t windowStartCounter = 0;
+        std::chrono::steady_clock::time_point windowStartTime;
+        uint64_t start = 0;
+
+        // Published stats, written by the audio thread and read by the UI
+        std::atomic<float> meanCycles{0.0f};
+        std::atomic<float> p99Cycles{0.0f};
+        std::atomic<float> maxCycles{0.0f};
+        std::atomic<float> budgetPercent{0.0f};
+        std::atomic<bool> resetRequested{false};
+        // Set from the menu, read by the audio thread before each process()
+        std::atomic<bool> enabled{false};
+
+        static int bucketOf(uint32_t cycles)
+        {
+            if (cycles < 4)
+                return cycles;
+            int octave = 31 - __builtin_clz(cycles);
+            int sub = (cycles >> (octave - 2)) & 3;
+            return octave * 4 + sub - 4;
+        }
+
+        // Lower edge of a bucket in cycles
+        static uint32_t bucketFloor(int bucket)
+        {
+            if (bucket < 4)
+                return bucket;
+            int octave = (bucket + 4) / 4;
+            int sub = (bucket + 4) % 4;
+            return (4u + sub) << (octave - 2);
+        }
+
+        void begin()
+        {
+            start = readCounter();
+        }
+
+        void end(float sampleRate)
+        {
+            uint64_t cycles64 = readCounter() - start;
+            uint32_t cycles = cycles64 > UINT32_MAX ? UINT32_MAX : (uint32_t)cycles64;
+
+            histogram[bucketOf(cycles)]++;
+            sum += cycles;
+            if (cycles > max)
+                max = cycles;
+
+            if (++count >= window)
+                publish(sampleRate);
+        }
+
+        void publish(float sampleRate)
+        {
+            if (resetRequested.exchange(false))
+            {
+                meanCycles = 0.0f;
+                p99Cycles = 0.0f;
+                maxCycles = 0.0f;
+                budgetPercent = 0.0f;
+            }
+            else
+            {
+                // Find the bucket holding the 99th percentile sample
+                uint32_t target = count - count / 100;
+                uint32_t seen = 0;
+                int bucket = 0;
+                for (; bucket < BUCKETS - 1; bucket++)
+                {
+                    seen += histogram[bucket];
+                    if (seen >= target)
+                        break;
+                }
+
+                float mean = (float)sum / count;
+                meanCycles = mean;
+                p99Cycles = (float)bucketFloor(bucket);
+                maxCycles = (float)max;
+
+                // Counter rate measured against the wall clock over the same window
+                auto now = std::chrono::steady_clock::now();
+                uint64_t counterNow = readCounter();
+                if (windowStartCounter)
+                {
+                    double seconds = std::chrono::duration<double>(now - windowStartTime).count();
+                    double counterRate = (counterNow - windowStartCounter) / seconds;
+                    if (counterRate > 0.0)
+                        budgetPercent = (float)(100.0 * mean * sampleRate / counterRate);
+                }
+                windowStartCounter = counterNow;
+                windowStartTime = now;
+            }
+
+            for (int i = 0; i < BUCKETS; i++)
+                histogram[i] = 0;
+            sum = 0;
+            max = 0;
+            count = 0;
+            window = (uint32_t)sampleRate;
+        }
+    };
+
+    // Non-template side of Timed<> so widgets can find the timer without knowing the module type
+    struct TimedModule
+    {
+        DSPTimer dspTimer;
+        // Debug flag, when set the last stats are saved with the patch
+        bool saveTiming = false;
+    };
+
+    template <class TModule>
+    struct Timed : TModule, TimedModule
+    {
+        void process(const typename TModule::ProcessArgs &args) override
+        {
+            if (!dspTimer.enabled.load(std::memory_order_relaxed))
+            {
+                TModule::process(args);
+                return;
+            }
+            dspTimer.begin();
+            TModule::process(args);
+            dspTimer.end(args.sampleRate);
+        }
+
+        json_t *dataToJson() override
+        {
+            json_t *rootJ = TModule::dataToJson();
+            if (!saveTiming)
+                return rootJ;
+            if (!rootJ)
+                rootJ = json_object();
+
+            json_t *timingJ = json_object();
+            json_object_set_new(timingJ, "meanCycles", json_real(dspTimer.meanCycles));
+            json_object_set_new(timingJ, "p99Cycles", json_real(dspTimer.p99Cycles));
+            json_object_set_new(timingJ, "maxCycles", json_real(dspTimer.maxCycles));
+            json_object_set_new(timingJ, "budgetPercent", json_real(dspTimer.budgetPercent));
+            json_object_set_new(timingJ, "unit", json_string(COUNTER_UNIT));
+            json_object_set_new(rootJ, "dspTiming", timingJ);
+            json_object_set_new(rootJ, "saveTiming", json_boolean(saveTiming));
+            return rootJ;
+        }
+
+        void dataFromJson(json_t *rootJ) override
+        {
+            TModule::dataFromJson(rootJ);
+            json_t *saveTimingJ = json_object_get(rootJ, "saveTiming");
+            if (saveTimingJ)
+                saveTiming = json_boolean_value(saveTimingJ);
+        }
+    };
+
+    template <class TModuleWidget>
+    struct TimedWidget : TModuleWidget
+    {
+        template <class TModule>
+        TimedWidget(TModule *module) : TModuleWidget(module) {}
+
+        void appendContextMenu(Menu *menu) override
+        {
+            TModuleWidget::appendContextMenu(menu);
+            TimedModule *timed = dynamic_cast<TimedModule *>(this->module);
+            if (!timed)
+                return;
+
+            DSPTimer &t = timed->dspTimer;
+            menu->addChild(new MenuSeparator);
+            menu->addChild(createBoolMenuItem("Measure DSP timing", "",
+                [=]() { return timed->dspTimer.enabled.load(); },
+                [=](bool enabled) {
+                    // Drop the stats of the previous run so they are not shown as current
+                    timed->dspTimer.resetRequested = true;
+                    timed->dspTimer.enabled = enabled;
+                }));
+            if (!t.enabled)
+                return;
+            menu->addChild(createMenuLabel(string::f("DSP timing (%s per sample)", COUNTER_UNIT)));
+            menu->addChild(createMenuLabel(string::f("Mean %.0f, %.2f%% of the audio budget", (float)t.meanCycles, (float)t.budgetPercent)));
+            menu->addChild(createMenuLabel(string::f("p99 %.0f, max %.0f", (float)t.p99Cycles, (float)t.maxCycles)));
+            menu->addChild(createMenuItem("Reset timing", "", [=]() {
+                timed->dspTimer.resetRequested = true;
+            }));
+            menu->addChild(createBoolPtrMenuItem("Save timing in patch (debug)", "", &timed->saveTiming));
+        }
+    };
+} // namespace NANOTiming
@@ -1,9 +1,22 @@
 #include "plugin.hpp"
 #include <componentlibrary.hpp>
 #include "NANOComponents.hpp"
+#include "NANOTiming.hpp"
+#include "Resources/SynthTools/pitchTable.hpp"
+#include "Resources/SynthTools/tableRegistry.hpp"
+#include "Resources/SynthTools/wavetables.hpp"
+#include "Resources/SynthTools/decimator.hpp"
+#include "Resources/SynthTools/minBlep.hpp"
+
+using simd::float_4;
 
 const float BASE_SCALE = 16.36f;
 const float LFO_SCALE = 0.255625f;
+const float LOG2_3 = 1.5849625f;
+
+//Voices follow the V/OCT channel count and run in groups of 4, one voice per float_4 lane
+const int MAX_VOICES = 16;
+const int VOICE_GROUPS = MAX_VOICES / 4;
 
 //Struct to handle potentiometer variables
 struct potentiometers
@@ -12,98 +25,68 @@ struct potentiometers
     float fine;
     float fm;
     float pw;
+    float spread;
 };
 
-//Struct to handle input variables
+//Struct to handle input variables of 4 voices
 struct ins
 {
-    float voct;
-    float fm;
-    float sync;
-    float pw;
+    float_4 voct;
+    float_4 fm;
+    float_4 sync;
+    float_4 pw;
 };
 
-//Struct to handle oscillator variables
+//Struct to handle oscillator variables of 4 voices, updated in place
 struct oscillator
 {
-    float pitch;
-    float frequency;
-    float octave;
-    float waveform;
-    float phase;
-    float phaseIncrement;
-    float delta;
-    float max;
-    float T;
-    float output;
-    float mix;
-    float outputMix;
-    uint32_t mode;
+    float_4 frequency;
+    float_4 waveform;
+    float_4 phase;
+    float_4 phaseIncrement;
+    float_4 T;
+    //Phase wraps counted modulo 4, the flip-flop dividers of the sub oscillators
+    float_4 wraps;
 };
 
-//Main VCO phase handler
-struct oscillator phasesHandler(oscillator p)
+//VCO phase handler, offset is the through-zero FM step
+void phasesHandler(oscillator &p, float delta, float max, float_4 offset = 0.0f)
 {
-
     //Main phase handler
-    p.phaseIncrement = p.frequency * p.delta;
+    p.phaseIncrement = p.frequency * delta + offset;
     //Prevent phase overflow
     p.phase += p.phaseIncrement;
-    //Reset control
-    if (p.phase >= p.max)
-    {
-        p.phase -= p.max;
-    }
+    //Reset control, both ways as through-zero FM runs the phase backwards
+    float_4 forward = p.phase >= max;
+    p.phase -= simd::ifelse(forward, max, 0.0f);
+    float_4 backward = p.phase < 0.0f;
+    p.phase += simd::ifelse(backward, max, 0.0f);
+    //Divider count
+    p.wraps += simd::ifelse(forward, 1.0f, 0.0f) - simd::ifelse(backward, 1.0f, 0.0f);
+    p.wraps -= simd::ifelse(p.wraps >= 4.0f, 4.0f, 0.0f);
+    p.wraps += simd::ifelse(p.wraps < 0.0f, 4.0f, 0.0f);
     //Phase ratio update
-    p.T = p.phase / p.max;
-
-    return p;
+    p.T = p.phase / max;
 }
 
 struct triggers
 {
-    float inputValue;
-    float clockValue;
-    float externalClock;
-    float triggerValue;
-    float triggerPastValue;
-    float gateValue;
-    float deltaTrigger;
-    float risingEdge;
+    float_4 triggerPastValue;
+    float_4 risingEdge;
+    //Where the input crossed the threshold, as a fraction of the sample in (0, 1]
+    float_4 crossing;
 };
 
-struct triggers syncTriggerHandler(triggers t)
+void syncTriggerHandler(triggers &t, float_4 inputValue)
 {
-
-    //Trigger & Gate activated at rising edge
-    if (t.inputValue > 0.7f && t.triggerPastValue < 0.7f)
-    {
-
-        t.triggerValue = 1.0f;
-        t.gateValue = 1.0f;
-        t.risingEdge = 1.0f;
-
-        //Trigger & Gate deactivated at falling edge
-    }
-    else if (t.inputValue < 0.7f && t.triggerPastValue > 0.7f)
-    {
-
-        t.triggerValue = 0.0f;
-        t.gateValue = 0.0f;
-
-        //Trigger deactivated if triggered before
-    }
-    else if (t.inputValue > 0.7f && t.triggerPastValue > 0.7f)
-    {
-
-        t.triggerValue = 0.0f;
-        t.risingEdge = 0.0f;
-    }
+    //Rising edge on the first sample at the threshold, once per edge
+    t.risingEdge = (inputValue >= 0.7f) & (t.triggerPastValue < 0.7f);
+    //Linear interpolation between the two samples, the other lanes may divide by 0
+    float_4 crossing = (0.7f - t.triggerPastValue) / (inputValue - t.triggerPastValue);
+    t.crossing = simd::ifelse(t.risingEdge, crossing, 1.0f);
 
     //State controller
-    t.triggerPastValue = t.inputValue;
-
-    return t;
+    t.triggerPastValue = inputValue;
 }
 
 //Just some maths values
@@ -116,9 +99,44 @@ struct maths
 struct ONA : Module
 {
     float deltaTime = 1.0f / 44100.0f;
-    float morph1 = 0.0f;
-    float morph2 = 0.0f;
     float phaseChange = 0.0f;
+    int channels = 1;
+
+    //Band limiting of the triangle, saw, pulse and subs, chosen from the context menu
+    enum Engines
+    {
+        POLYBLEP_ENGINE,
+        WAVETABLE_ENGINE,
+        NUM_ENGINES
+    };
+    int engine = POLYBLEP_ENGINE;
+
+    //Oversampling of the linear FM, only while the FM input is patched
+    enum FMOversampling
+    {
+        FM_OVERSAMPLING_OFF,
+        FM_OVERSAMPLING_2X,
+        FM_OVERSAMPLING_4X,
+        NUM_FM_OVERSAMPLINGS
+    };
+    int fmOversampling = FM_OVERSAMPLING_OFF;
+    static const int MAX_OVERSAMPLING = 4;
+    //Factor the last sample ran at, shown in the context menu
+    int activeOversampling = 1;
+
+    //Detuned copies of every voice, packed in the lanes of its voice groups
+    enum Unisons
+    {
+        UNISON_OFF,
+        UNISON_4,
+        UNISON_8,
+        NUM_UNISONS
+    };
+    int unison = UNISON_OFF;
+    //The copies are panned across a stereo pair, each voice takes 2 channels, left then right
+    bool unisonStereo = false;
+    //Mode the copies were laid out for
+    int activeUnison = UNISON_OFF;
 
     enum ParamIds
     {
@@ -128,6 +146,7 @@ struct ONA : Module
         PW_PARAM,
         FM_SW_PARAM,
         MODE_PARAM,
+        UNISON_SPREAD_PARAM,
         NUM_PARAMS
     };
     enum InputIds
@@ -155,12 +174,34 @@ struct ONA : Module
     potentiometers potsValue;
     maths mathsValue;
     ins inputsValue;
-    //3 VCOs required, main and both subs
-    oscillator mainVCO;
-    oscillator sub1VCO;
-    oscillator sub2VCO;
+    //One VCO per group of 4 voices, the subs are divided down from its wraps. A voice has a single
+    //phase accumulator, so the lanes hold voices rather than a voice's main and sub phases
+    oscillator mainVCO[VOICE_GROUPS];
     //Sync trigger handler
-    triggers syncTrigger;
+    triggers syncTrigger[VOICE_GROUPS];
+    //Band-limited steps of the hard sync, per output and voice group, all reading one shared impulse
+    static const int BLEP_ZEROS = 16;
+    SharedMinBlep<BLEP_ZEROS, 16> syncBLEP[NUM_OUTPUTS][VOICE_GROUPS];
+    //Samples left before the steps are played out, the generators are skipped in between syncs
+    int syncTail[VOICE_GROUPS];
+    //Shared V/Oct to frequency table
+    std::shared_ptr<const PitchTable> pitchTable = TableRegistry::acquire<PitchTable>();
+    //Patched outputs, the morphs are built from the triangle, saw and pulse
+    bool patched[NUM_OUTPUTS] = {};
+    bool triangleOn = false, sawOn = false, pulseOn = false;
+    //Linear FM of the previous sample, interpolated across the oversampled steps
+    float_4 fmPrevious[VOICE_GROUPS];
+    //Back to the sample rate, per output and voice group
+    Decimator<float_4> decimators[NUM_OUTPUTS][VOICE_GROUPS];
+    //Shared band-limited waveforms for the wavetable engine
+    std::shared_ptr<const MipmapWavetables> wavetables = TableRegistry::acquire<MipmapWavetables>();
+    //Unison copies of the groups of one voice, detune from -1 to 1 and their stereo gains
+    static const int MAX_UNISON_GROUPS = 2;
+    float_4 unisonDetune[MAX_UNISON_GROUPS];
+    float_4 unisonLeft[MAX_UNISON_GROUPS];
+    float_4 unisonRight[MAX_UNISON_GROUPS];
+    //The copies sum to the level of a single voice
+    float unisonGain = 1.0f;
 
     ONA()
     {
@@ -174,6 +215,7 @@ struct ONA : Module
 
         configSwitch(FM_SW_PARAM, 0.f, 1.f, 1.0f, "FM Mode",  {"Exponential", "Linear"});
         configSwitch(MODE_PARAM, 0.f, 1.f, 1.0f, "Oscillator Mode",  {"LFO", "VCO"});
+        configParam(UNISON_SPREAD_PARAM, 0.f, 1.f, 0.25f, "Unison spread", " cents", 0.f, 100.f);
 
         configInput(FM_INPUT, "FM");
         configInput(OCT_INPUT, "V/OCT");
@@ -194,93 +236,208 @@ struct ONA : Module
         mathsValue.PI = 3.141592653589793f;
         mathsValue.twoPI = 2.0f * mathsValue.PI;
 
-        mainVCO.max = mathsValue.twoPI;
-        mainVCO.phase = mathsValue.twoPI;
-        mainVCO.frequency = 110.0f;
-
-        sub1VCO.max = mathsValue.twoPI;
-        sub1VCO.phase = mathsValue.twoPI;
-        sub1VCO.frequency = 110.0f;
-
-        sub2VCO.max = mathsValue.twoPI;
-        sub2VCO.phase = mathsValue.twoPI;
-        sub2VCO.frequency = 110.0f;
-
-        syncTrigger.inputValue = 0.0f;
-        syncTrigger.clockValue = 0.0f;
-        syncTrigger.externalClock = 0.0f;
-        syncTrigger.triggerValue = 0.0f;
-        syncTrigger.triggerPastValue = 0.0f;
-        syncTrigger.gateValue = 0.0f;
-        syncTrigger.deltaTrigger = 12.0f;
-        syncTrigger.risingEdge = 0.0f;
+        for (int g = 0; g < VOICE_GROUPS; g++)
+        {
+            mainVCO[g].frequency = 110.0f;
+            mainVCO[g].waveform = 0.5f;
+            mainVCO[g].phase = mathsValue.twoPI;
+            mainVCO[g].phaseIncrement = 0.0f;
+            mainVCO[g].T = 0.0f;
+            //The phase starts on a wrap, which brings the count to 0 with both subs high
+            mainVCO[g].wraps = 3.0f;
+
+            syncTrigger[g].triggerPastValue = 0.0f;
+            syncTrigger[g].risingEdge = 0.0f;
+            syncTrigger[g].crossing = 1.0f;
+            syncTail[g] = 0;
+            fmPrevious[g] = 0.0f;
+        }
     }
 
-    //PolyBLEP anti-aliasing function
-    double PolyBLEP(double t, double phaseIncrement)
+    //PolyBLEP anti-aliasing function, dt is the phase increment as a fraction of the period
+    float_4 PolyBLEP(float_4 t, float_4 dt, float_4 invDt)
     {
-
-        double dt = phaseIncrement / mathsValue.twoPI;
         // 0 <= t < 1
-        if (t < dt)
-        {
-            t /= dt;
-            return t + t - t * t - 1.0;
-        } // -1 < t < 0
-        else if (t > 1.0 - dt)
-        {
-            t = (t - 1.0) / dt;
-            return t * t + t + t + 1.0;
-        }
+        float_4 start = t * invDt;
+        start = start + start - start * start - 1.0f;
+        // -1 < t < 0
+        float_4 end = (t - 1.0f) * invDt;
+        end = end * end + end + end + 1.0f;
         // 0 otherwise
-        else
-            return 0.0;
+        return simd::ifelse(t < dt, start, simd::ifelse(t > 1.0f - dt, end, 0.0f));
     }
 
     //Sine wave shaper
-    double sineWave(float phase)
+    float_4 sineWave(float_4 phase)
     {
         //Compute the SINE output
-        return -10.0f * std::cos(phase);
+        return -10.0f * simd::cos(phase);
     }
 
-    //Triangle wave shaper
-    double triangleWave(float phase)
+    //Triangle wave shaper, T is the phase ratio
+    float_4 triangleWave(float_4 T)
     {
         //Compute the TRIANGLE output
-        double tri = -1.0 + (2.0 * phase / mathsValue.twoPI);
-        tri = 2.0 * (fabs(tri) - 0.5);
+        float_4 tri = -1.0f + 2.0f * T;
+        tri = 2.0f * (simd::abs(tri) - 0.5f);
         return -tri * 10.0f;
     }
 
-    //Saw (BLEP) wave shaper
-    double sawWave(float phase, double T, double phaseIncrement)
+    //Saw (BLEP) wave shaper, riseBLEP is the correction at the phase wrap
+    float_4 sawWave(float_4 T, float_4 riseBLEP)
     {
         //Compute the SAW output
-        double saw = (2.0 * phase / mathsValue.twoPI) - 1.0;
-        saw -= PolyBLEP(T, phaseIncrement);
+        float_4 saw = 2.0f * T - 1.0f;
+        saw -= riseBLEP;
         return saw * 10.0f;
     }
 
-    //Pulse (BLEP) wave shaper
-    double pulseWave(float phase, float duty, double T, double phaseIncrement)
+    //Pulse (BLEP) wave shaper, shares the wrap correction with the saw
+    float_4 pulseWave(float_4 T, float_4 duty, float_4 riseBLEP, float_4 dt, float_4 invDt)
     {
         //Compute the PULSE output
-        double pul = 0.0f;
-        if (phase < duty * mathsValue.twoPI)
+        float_4 pul = simd::ifelse(T < duty, 1.0f, -1.0f);
+        pul += riseBLEP;
+        //Falling edge position, wrapped into [0, 1)
+        float_4 fallT = T + (1.0f - duty);
+        fallT -= simd::ifelse(fallT >= 1.0f, 1.0f, 0.0f);
+        pul -= PolyBLEP(fallT, dt, invDt);
+        return pul * 10.0f;
+    }
+
+    //Pulse (wavetable) wave shaper, the difference of the band-limited saw and a copy delayed by the duty cycle
+    float_4 tablePulseWave(float_4 T, float_4 duty, float_4 level, float_4 saw)
+    {
+        float_4 fallT = T - duty;
+        fallT += simd::ifelse(fallT < 0.0f, 1.0f, 0.0f);
+        float_4 pul = 2.0f * duty - 1.0f - saw + wavetables->read(MipmapWavetables::SAW, level, fallT);
+        return pul * 10.0f;
+    }
+
+    //Flip-flop divider sub oscillators (BLEP), square waves that only step on the main phase wraps
+    //Sub 1 toggles on every wrap and sub 2 on every other one, so both stay locked to the main phase
+    //and share its wrap correction
+    void dividerWaves(const oscillator &main, float_4 wrapBLEP, float_4 &sub1, float_4 &sub2)
+    {
+        float_4 odd = main.wraps - 2.0f * simd::floor(main.wraps * 0.5f);
+        float_4 sub1Level = 1.0f - 2.0f * odd;
+        float_4 sub2Level = simd::ifelse(main.wraps < 2.0f, 1.0f, -1.0f);
+        //Past the wrap the level is the one the step went to, before it the step goes to the opposite one
+        float_4 early = main.T < 0.5f;
+        sub1 = sub1Level + simd::ifelse(early, sub1Level, -sub1Level) * wrapBLEP;
+        //Sub 2 only steps on the wraps into an even count
+        float_4 toggles = simd::ifelse(early, odd == 0.0f, odd == 1.0f);
+        sub2 = sub2Level + simd::ifelse(toggles, simd::ifelse(early, sub2Level, -sub2Level) * wrapBLEP, 0.0f);
+        sub1 *= 10.0f;
+        sub2 *= 10.0f;
+    }
+
+    //Divider sub oscillators (wavetable), the sub phases follow from the wrap count
+    void tableDividerWaves(const oscillator &main, float_4 level, float_4 &sub1, float_4 &sub2)
+    {
+        float_4 odd = main.wraps - 2.0f * simd::floor(main.wraps * 0.5f);
+        sub1 = 10.0f * wavetables->read(MipmapWavetables::SQUARE, simd::fmax(level - 1.0f, 0.0f), (odd + main.T) * 0.5f);
+        sub2 = 10.0f * wavetables->read(MipmapWavetables::SQUARE, simd::fmax(level - 2.0f, 0.0f), (main.wraps + main.T) * 0.25f);
+    }
+
+    //Output voltages from the base waveforms
+    void Outputs_Handler(float_4 sine, float_4 triangle, float_4 saw, float_4 pulse, float_4 sub1, float_4 sub2, float_4 *values)
+    {
+        //Just output value writing
+        values[SINE_OUTPUT] = sine * 0.5f;
+        values[TRIANGLE_OUTPUT] = triangle * 0.5f;
+        values[SAW_OUTPUT] = saw * 0.5f;
+        values[PULSE_OUTPUT] = pulse * 0.5f;
+
+        //Complex waveform generator, acts like an analog switch
+        //While the pulse wave is positive the switch is open and the triangle (morph1) or saw (morph2)
+        //is added to the inverted triangle, which cancels it out for morph1
+        float_4 open = pulse > 0.0f;
+        values[MORPH1_OUTPUT] = simd::ifelse(open, 0.0f, -triangle) * 0.5f;
+        values[MORPH2_OUTPUT] = simd::ifelse(open, saw - triangle, -triangle) * 0.5f;
+
+        //Set sub output values
+        values[SUB1_OUTPUT] = sub1 * 0.5f;
+        values[SUB2_OUTPUT] = sub2 * 0.5f;
+    }
+
+    //Every output without band limiting, the levels the hard sync jumps between
+    void naiveWaves(const oscillator &state, float_4 *values)
+    {
+        float_4 sub1, sub2;
+        dividerWaves(state, 0.0f, sub1, sub2);
+        float_4 pulse = simd::ifelse(state.T < state.waveform, 10.0f, -10.0f);
+        Outputs_Handler(sineWave(state.phase), triangleWave(state.T), sawWave(state.T, 0.0f), pulse, sub1, sub2, values);
+    }
+
+    //Hard sync of the lanes in sync, which crossed at the given fraction of the last phase step.
+    //The phase restarts from 0 and runs for the rest of the step
+    void syncPhases(oscillator &main, float_4 sync, float_4 crossing)
+    {
+        float_4 phase = (1.0f - crossing) * main.phaseIncrement;
+        //Through-zero FM restarts it backwards, through the last wrap
+        float_4 backward = phase < 0.0f;
+        phase += simd::ifelse(backward, mathsValue.twoPI, 0.0f);
+        main.phase = simd::ifelse(sync, phase, main.phase);
+        main.wraps = simd::ifelse(sync, simd::ifelse(backward, 3.0f, 0.0f), main.wraps);
+        main.T = main.phase / mathsValue.twoPI;
+    }
+
+    //Band-limited hard sync of the lanes in sync of voice group g, after its phase step. The step is
+    //rolled back to the crossing, where every output jumps from its level there to the one at phase 0,
+    //and the jumps are spread by the MinBLEPs. Oversampled, the steps are the oversampled ones and the
+    //MinBLEPs run at the oversampled rate ahead of the decimators
+    void Sync_Handler(int g, float_4 sync, float_4 fraction)
+    {
+        oscillator &main = mainVCO[g];
+
+        //State at the crossing, undoing a wrap after it, backwards too under through-zero FM
+        oscillator crossing = main;
+        crossing.phase -= (1.0f - fraction) * main.phaseIncrement;
+        float_4 unwrap = crossing.phase < 0.0f;
+        crossing.phase += simd::ifelse(unwrap, mathsValue.twoPI, 0.0f);
+        crossing.wraps -= simd::ifelse(unwrap, 1.0f, 0.0f);
+        float_4 rewrap = crossing.phase >= mathsValue.twoPI;
+        crossing.phase -= simd::ifelse(rewrap, mathsValue.twoPI, 0.0f);
+        crossing.wraps += simd::ifelse(rewrap, 1.0f, 0.0f);
+        crossing.wraps -= simd::ifelse(crossing.wraps >= 4.0f, 4.0f, 0.0f);
+        crossing.wraps += simd::ifelse(crossing.wraps < 0.0f, 4.0f, 0.0f);
+        crossing.T = crossing.phase / mathsValue.twoPI;
+        oscillator restart = main;
+        restart.phase = 0.0f;
+        restart.wraps = 0.0f;
+        restart.T = 0.0f;
+
+        float_4 before[NUM_OUTPUTS], after[NUM_OUTPUTS];
+        naiveWaves(crossing, before);
+        naiveWaves(restart, after);
+        //Each lane crossed at its own time, the lanes out of sync get no step
+        float_4 position = simd::ifelse(sync, fraction - 1.0f, 1.0f);
+        for (int o = 0; o < NUM_OUTPUTS; o++)
         {
-            pul = 1.0;
+            if (patched[o])
+                syncBLEP[o][g].insertDiscontinuity(position, after[o] - before[o]);
         }
-        else
+        syncTail[g] = 2 * BLEP_ZEROS;
+
+        syncPhases(main, sync, fraction);
+    }
+
+    //Steps of the last syncs of voice group g added to its outputs, once per phase step. Unpatched
+    //outputs get no steps, their generators are cleared when the output is patched again
+    void Sync_Tail(int g, float_4 *values)
+    {
+        if (syncTail[g] <= 0)
+            return;
+        syncTail[g]--;
+        for (int o = 0; o < NUM_OUTPUTS; o++)
         {
-            pul = -1.0;
+            if (patched[o])
+                values[o] += syncBLEP[o][g].process();
         }
-        pul += PolyBLEP(T, phaseIncrement);
-        pul -= PolyBLEP(fmod(T + (1.0f - duty), 1.0), phaseIncrement);
-        return pul * 10.0f;
     }
 
-    //Parameters, pots and inputs monitoring
+    //Parameters and pots monitoring
     void Values_Handler(void)
     {
         //POTENTIOMETER READINGS
@@ -292,147 +449,379 @@ struct ONA : Module
         potsValue.fm = params[FM_PARAM].getValue();
         potsValue.pw = params[PW_PARAM].getValue();
 
-        //INPUTS READINGS
+        //Unison copies detune up to a semitone either way
+        potsValue.spread = params[UNISON_SPREAD_PARAM].getValue() * 0.08333333f;
+    }
+
+    //Inputs monitoring for the 4 voices starting at channel c, mono inputs are shared by every voice
+    void Inputs_Handler(int c)
+    {
         //V.Oct related CV ins
-        inputsValue.voct = inputs[OCT_INPUT].getVoltage();
+        inputsValue.voct = inputs[OCT_INPUT].getPolyVoltageSimd<float_4>(c);
         //Freq related CV ins
-        inputsValue.fm = inputs[FM_INPUT].getVoltage();
-        inputsValue.sync = inputs[SYNC_INPUT].getVoltage();
+        inputsValue.fm = inputs[FM_INPUT].getPolyVoltageSimd<float_4>(c);
+        inputsValue.sync = inputs[SYNC_INPUT].getPolyVoltageSimd<float_4>(c);
         //Shape related CV ins
-        inputsValue.pw = inputs[PW_INPUT].getVoltage();
+        inputsValue.pw = inputs[PW_INPUT].getPolyVoltageSimd<float_4>(c);
     }
 
-    //Deduce variables from the parameters pots and inputs
-    void Variable_Handler(void)
+    //Inputs monitoring for the unison copies of voice v in their group h, detuned by the spread
+    void Unison_Inputs_Handler(int v, int h)
     {
-        //VARIABLE COMPUTING
-
-        //Sync handler
-        syncTrigger.inputValue = inputsValue.sync;
-        syncTrigger = syncTriggerHandler(syncTrigger);
+        inputsValue.voct = inputs[OCT_INPUT].getPolyVoltage(v) + unisonDetune[h] * potsValue.spread;
+        inputsValue.fm = inputs[FM_INPUT].getPolyVoltage(v);
+        inputsValue.sync = inputs[SYNC_INPUT].getPolyVoltage(v);
+        inputsValue.pw = inputs[PW_INPUT].getPolyVoltage(v);
+    }
 
-        if (syncTrigger.risingEdge >= 1.0f)
+    //Lays the unison copies out for the current mode: evenly spread detune, panned to alternate sides
+    //from the outside in so each side gets wide and narrow detunes, and phases spread by the golden ratio
+    //so the copies never start in unison
+    void Unison_Layout(void)
+    {
+        int copies = unison == UNISON_8 ? 8 : 4;
+        //Detuned copies add up in power
+        unisonGain = 1.0f / std::sqrt((float)copies);
+        for (int k = 0; k < copies; k++)
+        {
+            float position = -1.0f + 2.0f * k / (copies - 1);
+            float pan = (k & 1) ? std::fabs(position) : -std::fabs(position);
+            unisonDetune[k / 4][k % 4] = position;
+            //Equal power
+            unisonLeft[k / 4][k % 4] = unisonGain * std::cos((pan + 1.0f) * 0.25f * mathsValue.PI);
+            unisonRight[k / 4][k % 4] = unisonGain * std::sin((pan + 1.0f) * 0.25f * mathsValue.PI);
+        }
+        for (int g = 0; g < VOICE_GROUPS; g++)
         {
-            mainVCO.phase = 0.0f;
-            sub1VCO.phase = 0.0f;
-            sub2VCO.phase = 0.0f;
+            for (int i = 0; i < 4; i++)
+            {
+                int k = (g * 4 + i) % copies;
+                float start = k * 0.618034f;
+                mainVCO[g].phase[i] = (start - std::floor(start)) * mathsValue.twoPI;
+                mainVCO[g].wraps[i] = (float)(k & 3);
+            }
         }
+    }
+
+    //Deduce variables from the parameters pots and inputs for voice group g
+    //With oversampledFM the linear FM is left to the oversampled phase steps
+    void Variable_Handler(int g, bool linearFM, bool oversampledFM, bool resetPhases, bool vcoMode)
+    {
+        //VARIABLE COMPUTING
+        oscillator &main = mainVCO[g];
+
+        //Sync handler, the phases are reset once they have been stepped
+        syncTriggerHandler(syncTrigger[g], inputsValue.sync);
 
         //VCO frequency
         //Octave switch
-        mainVCO.pitch = (uint32_t)potsValue.octave;
+        float_4 pitch = (float)(uint32_t)potsValue.octave;
         //Sum fine frequency adjust
-        mainVCO.pitch += potsValue.fine * 0.08333333f;
+        pitch += potsValue.fine * 0.08333333f;
         //Sum V/OCT input voltage
-        mainVCO.pitch += inputsValue.voct;
+        pitch += inputsValue.voct;
 
         //Linear or exponential FM
-        if (params[FM_SW_PARAM].getValue())
+        if (linearFM && !oversampledFM)
         {
             //Linear FM is basically phase modulation
-            mainVCO.phase += inputsValue.fm * potsValue.fm * 0.01f;
-            sub1VCO.phase += inputsValue.fm * potsValue.fm * 0.005f;
-            sub2VCO.phase += inputsValue.fm * potsValue.fm * 0.0025f;
+            main.phase += inputsValue.fm * potsValue.fm * 0.01f;
             //Just don't go out of the limits
-            mainVCO.phase = clamp(mainVCO.phase, 0.0f, mathsValue.twoPI);
-            sub1VCO.phase = clamp(sub1VCO.phase, 0.0f, mathsValue.twoPI);
-            sub2VCO.phase = clamp(sub2VCO.phase, 0.0f, mathsValue.twoPI);
-
-            //Notify phase change
-            phaseChange = 1.0f;
+            main.phase = simd::clamp(main.phase, float_4(0.0f), float_4(mathsValue.twoPI));
         }
-        else
+        else if (!linearFM)
         {
             //Exponential FM
-            mainVCO.pitch += inputsValue.fm * potsValue.fm;
-            //If we come from linear FM, reset phase;
-            if (phaseChange)
+            pitch += inputsValue.fm * potsValue.fm;
+            //If we come from linear FM, reset phase
+            if (resetPhases)
             {
-                mainVCO.phase = 0.0f;
-                sub1VCO.phase = 0.0f;
-                sub2VCO.phase = 0.0f;
-                phaseChange = 0.0f;
+                main.phase = 0.0f;
+                main.wraps = 0.0f;
             }
         }
 
         //VCO or LFO mode
-        if (params[MODE_PARAM].getValue())
+        float_4 frequency;
+        if (vcoMode)
         {
             //Frequency of the VCO is calculated with the power of the previous voltage sum
-            mainVCO.frequency = clamp((BASE_SCALE * mathsValue.twoPI * std::pow(2, mainVCO.pitch)), 0.01f, 22100.0f * mathsValue.twoPI);
+            frequency = BASE_SCALE * mathsValue.twoPI * pitchTable->exp2(pitch);
         }
         else
         {
-            //Frequency of the LFO is calculated with the power of the previous voltage sum
-            mainVCO.frequency = clamp((LFO_SCALE / 64.0f * mathsValue.twoPI * std::pow(3, mainVCO.pitch)), 0.01f, 22100.0f * mathsValue.twoPI);
+            //Frequency of the LFO is calculated with the power of 3 of the previous voltage sum
+            frequency = LFO_SCALE / 64.0f * mathsValue.twoPI * pitchTable->exp2(pitch * LOG2_3);
         }
+        frequency = simd::clamp(frequency, float_4(0.01f), float_4(22100.0f * mathsValue.twoPI));
 
-        //Sub frequency update
-        sub1VCO.frequency = mainVCO.frequency / 2.0f;
-        sub2VCO.frequency = mainVCO.frequency / 4.0f;
+        main.frequency = frequency;
 
         //PWM control + attenuator
-        if (!inputs[PW_INPUT].getVoltage())
+        //Voices without PWM voltage get the value from the PWM pot, otherwise the pot is the attenuator
+        float_4 potWidth = clamp(potsValue.pw, 0.01f, 1.0f);
+        float_4 cvWidth = simd::clamp(inputsValue.pw * potsValue.pw * 0.2f, float_4(0.01f), float_4(1.0f));
+        main.waveform = simd::ifelse(inputsValue.pw == 0.0f, potWidth, cvWidth);
+    }
+
+    //Output voltages of voice group g for the current phases, only the patched outputs are filled.
+    //Lanes set in synced restarted their phase in this step without a wrap
+    void Waveforms_Handler(int g, float_4 synced, float_4 *values)
+    {
+        oscillator &main = mainVCO[g];
+        bool subsOn = patched[SUB1_OUTPUT] || patched[SUB2_OUTPUT];
+
+        //Base waveforms, each one and its BLEP computed once
+        float_4 triangle = 0.0f, saw = 0.0f, pulse = 0.0f, sub1 = 0.0f, sub2 = 0.0f;
+        if (engine == WAVETABLE_ENGINE)
         {
-            //If there's no PWM input connected, get the value from the PWM pot
-            //mainVCO.waveform = clamp(potsValue.pw, 0.01f, 0.99f);
-            mainVCO.waveform = clamp(potsValue.pw, 0.01f, 1.0f);
+            //One table level for the 3 waveforms, the pulse reuses the saw read
+            float_4 level = MipmapWavetables::level(simd::abs(main.phaseIncrement) / mathsValue.twoPI);
+            if (triangleOn)
+                triangle = 10.0f * wavetables->read(MipmapWavetables::TRIANGLE, level, main.T);
+            if (sawOn || pulseOn)
+            {
+                float_4 rise = wavetables->read(MipmapWavetables::SAW, level, main.T);
+                saw = rise * 10.0f;
+                if (pulseOn)
+                    pulse = tablePulseWave(main.T, main.waveform, level, rise);
+            }
+            if (subsOn)
+                tableDividerWaves(main, level, sub1, sub2);
         }
         else
         {
-            //If there's PWM input connected, use the PWM pot as attenuator
-            mainVCO.waveform = clamp((inputsValue.pw * potsValue.pw * 0.2f), 0.01f, 1.0f);
+            if (triangleOn)
+                triangle = triangleWave(main.T);
+            if (sawOn || pulseOn || subsOn)
+            {
+                //The corrections depend on the position around the edges only, a phase running
+                //backwards under through-zero FM crosses them with the same residual
+                float_4 increment = simd::abs(main.phaseIncrement);
+                float_4 dt = increment / mathsValue.twoPI;
+                float_4 invDt = mathsValue.twoPI / increment;
+                //A phase restarted by the sync has its step corrected in Sync_Handler
+                float_4 riseBLEP = simd::ifelse(synced, 0.0f, PolyBLEP(main.T, dt, invDt));
+                if (sawOn)
+                    saw = sawWave(main.T, riseBLEP);
+                if (pulseOn)
+                    pulse = pulseWave(main.T, main.waveform, riseBLEP, dt, invDt);
+                if (subsOn)
+                    dividerWaves(main, riseBLEP, sub1, sub2);
+            }
         }
+
+        float_4 sine = patched[SINE_OUTPUT] ? sineWave(main.phase) : 0.0f;
+        Outputs_Handler(sine, triangle, saw, pulse, sub1, sub2, values);
     }
 
     void process(const ProcessArgs &args) override
     {
         //Sample rate update
         deltaTime = args.sampleTime;
-        mainVCO.delta = deltaTime;
-        sub1VCO.delta = deltaTime;
-        sub2VCO.delta = deltaTime;
 
-        //Parameters & CVs monitoring
+        //Voices follow the V/OCT input, unison copies take the voice groups of fewer voices
+        int copies = (unison == UNISON_8) ? 8 : (unison == UNISON_4) ? 4 : 1;
+        channels = std::max(1, inputs[OCT_INPUT].getChannels());
+        int voices = std::min(channels, MAX_VOICES / copies);
+        int outputChannels = channels;
+        if (copies > 1)
+            outputChannels = unisonStereo ? 2 * voices : voices;
+        for (int o = 0; o < NUM_OUTPUTS; o++)
+            outputs[o].setChannels(outputChannels);
+
+        //Parameters monitoring
         Values_Handler();
 
-        //Variable writing and handling
-        Variable_Handler();
+        bool linearFM = params[FM_SW_PARAM].getValue();
+        bool vcoMode = params[MODE_PARAM].getValue();
+        //Leaving linear FM resets every voice
+        bool resetPhases = !linearFM && phaseChange;
+        phaseChange = linearFM ? 1.0f : 0.0f;
+
+        //Oversampling costs about its factor in oscillator time plus the decimators of the patched outputs,
+        //it only runs while linear FM has something to modulate with
+        int oversampling = 1;
+        if (linearFM && inputs[FM_INPUT].isConnected())
+            oversampling = 1 << fmOversampling;
+        //Filter history from an earlier run would leak into the first samples
+        if (oversampling != activeOversampling)
+        {
+            for (int o = 0; o < NUM_OUTPUTS; o++)
+            {
+                for (int g = 0; g < VOICE_GROUPS; g++)
+                    decimators[o][g].reset();
+            }
+            activeOversampling = oversampling;
+        }
 
-        //Phase hander
-        mainVCO = phasesHandler(mainVCO);
-        sub1VCO = phasesHandler(sub1VCO);
-        sub2VCO = phasesHandler(sub2VCO);
+        //Only the waveforms feeding a patched output are computed
+        for (int o = 0; o < NUM_OUTPUTS; o++)
+        {
+            bool connected = outputs[o].isConnected();
+            //Steps left over from before the output was unpatched
+            if (connected && !patched[o])
+            {
+                for (int g = 0; g < VOICE_GROUPS; g++)
+                    syncBLEP[o][g].reset();
+            }
+            patched[o] = connected;
+        }
+        triangleOn = patched[TRIANGLE_OUTPUT] || patched[MORPH1_OUTPUT] || patched[MORPH2_OUTPUT];
+        sawOn = patched[SAW_OUTPUT] || patched[MORPH2_OUTPUT];
+        pulseOn = patched[PULSE_OUTPUT] || patched[MORPH1_OUTPUT] || patched[MORPH2_OUTPUT];
 
-        //Just output value writing
-        outputs[SINE_OUTPUT].setVoltage(sineWave(mainVCO.phase) * 0.5f);
-        outputs[TRIANGLE_OUTPUT].setVoltage(triangleWave(mainVCO.phase) * 0.5f);
-        outputs[SAW_OUTPUT].setVoltage(sawWave(mainVCO.phase, mainVCO.T, mainVCO.phaseIncrement) * 0.5f);
-        outputs[PULSE_OUTPUT].setVoltage(pulseWave(mainVCO.phase, mainVCO.waveform, mainVCO.T, mainVCO.phaseIncrement) * 0.5f);
+        //The copies restart spread out whenever the unison mode changes
+        if (unison != activeUnison)
+        {
+            if (unison != UNISON_OFF)
+                Unison_Layout();
+            activeUnison = unison;
+        }
 
-        //Complex waveform generator, acts like an analog switch
-        //If the pulse wave is positive, open the switch
-        if (pulseWave(mainVCO.phase, mainVCO.waveform, mainVCO.T, mainVCO.phaseIncrement) > 0.0f)
+        if (copies == 1)
         {
-            //Add triangle wave to the morph1 output, only when pulse wave is active
-            morph1 = +triangleWave(mainVCO.phase);
-            //Add saw wave to the morph2 output, only when pulse wave is active
-            morph2 = +sawWave(mainVCO.phase, mainVCO.T, mainVCO.phaseIncrement);
+            for (int c = 0; c < channels; c += 4)
+            {
+                //CVs monitoring
+                Inputs_Handler(c);
+
+                float_4 values[NUM_OUTPUTS];
+                Voice_Group(c / 4, oversampling, linearFM, resetPhases, vcoMode, values);
+
+                for (int o = 0; o < NUM_OUTPUTS; o++)
+                {
+                    if (patched[o])
+                        outputs[o].setVoltageSimd(values[o], c);
+                }
+            }
         }
         else
         {
-            //If not positive, don't add anything
-            morph1 = 0;
-            morph2 = 0;
+            int groups = copies / 4;
+            for (int v = 0; v < voices; v++)
+            {
+                float_4 left[NUM_OUTPUTS], right[NUM_OUTPUTS];
+                for (int h = 0; h < groups; h++)
+                {
+                    Unison_Inputs_Handler(v, h);
+
+                    float_4 values[NUM_OUTPUTS];
+                    Voice_Group(v * groups + h, oversampling, linearFM, resetPhases, vcoMode, values);
+
+                    for (int o = 0; o < NUM_OUTPUTS; o++)
+                    {
+                        if (!patched[o])
+                            continue;
+                        if (h == 0)
+                            left[o] = right[o] = 0.0f;
+                        if (unisonStereo)
+                        {
+                            left[o] += values[o] * unisonLeft[h];
+                            right[o] += values[o] * unisonRight[h];
+                        }
+                        else
+                            left[o] += values[o];
+                    }
+                }
+
+                //Copies summed across the lanes
+                for (int o = 0; o < NUM_OUTPUTS; o++)
+                {
+                    if (!patched[o])
+                        continue;
+                    float l = left[o][0] + left[o][1] + left[o][2] + left[o][3];
+                    float r = right[o][0] + right[o][1] + right[o][2] + right[o][3];
+                    if (unisonStereo)
+                    {
+                        outputs[o].setVoltage(l, 2 * v);
+                        outputs[o].setVoltage(r, 2 * v + 1);
+                    }
+                    else
+                        outputs[o].setVoltage(l * unisonGain, v);
+                }
+            }
         }
+    }
 
-        //Set morph output values
-        outputs[MORPH1_OUTPUT].setVoltage((-triangleWave(mainVCO.phase) + morph1) * 0.5f);
-        outputs[MORPH2_OUTPUT].setVoltage((-triangleWave(mainVCO.phase) + morph2) * 0.5f);
+    //Runs voice group g for one sample from the inputs last read, values gets its output voltages
+    void Voice_Group(int g, int oversampling, bool linearFM, bool resetPhases, bool vcoMode, float_4 *values)
+    {
+        oscillator &main = mainVCO[g];
 
-        //Set sub output values
-        outputs[SUB1_OUTPUT].setVoltage(pulseWave(sub1VCO.phase, 0.5f, sub1VCO.T, sub1VCO.phaseIncrement) * 0.5f);
-        outputs[SUB2_OUTPUT].setVoltage(pulseWave(sub2VCO.phase, 0.5f, sub2VCO.T, sub2VCO.phaseIncrement) * 0.5f);
+        //Variable writing and handling
+        Variable_Handler(g, linearFM, oversampling > 1, resetPhases, vcoMode);
+
+        float_4 fm = inputsValue.fm * potsValue.fm;
+        float_4 sync = syncTrigger[g].risingEdge;
+        if (oversampling == 1)
+        {
+            //Phase hander, the phases run even when nothing is patched
+            phasesHandler(main, deltaTime, mathsValue.twoPI);
+            if (simd::movemask(sync))
+                Sync_Handler(g, sync, syncTrigger[g].crossing);
+
+            Waveforms_Handler(g, sync, values);
+            Sync_Tail(g, values);
+        }
+        else
+        {
+            //Through-zero linear FM, the same deviation per sample as the plain linear FM spread over the steps
+            float_4 steps[NUM_OUTPUTS][MAX_OVERSAMPLING];
+            float delta = deltaTime / oversampling;
+            for (int s = 0; s < oversampling; s++)
+            {
+                //Modulator interpolated between the samples
+                float_4 step = fmPrevious[g] + (fm - fmPrevious[g]) * ((s + 1) / (float)oversampling);
+                step *= 0.01f / oversampling;
+                phasesHandler(main, delta, mathsValue.twoPI, step);
+                //The sync restarts the phase in the step it crossed in
+                float_4 crossing = syncTrigger[g].crossing * (float)oversampling - (float)s;
+                float_4 stepSync = sync & (crossing > 0.0f) & (crossing <= 1.0f);
+                if (simd::movemask(stepSync))
+                    Sync_Handler(g, stepSync, crossing);
+
+                Waveforms_Handler(g, stepSync, values);
+                Sync_Tail(g, values);
+                for (int o = 0; o < NUM_OUTPUTS; o++)
+                {
+                    if (patched[o])
+                        steps[o][s] = values[o];
+                }
+            }
+            for (int o = 0; o < NUM_OUTPUTS; o++)
+            {
+                if (patched[o])
+                    values[o] = decimators[o][g].process(steps[o], oversampling);
+            }
+        }
+        fmPrevious[g] = fm;
+    }
+
+    json_t *dataToJson() override
+    {
+        json_t *rootJ = json_object();
+        json_object_set_new(rootJ, "engine", json_integer(engine));
+        json_object_set_new(rootJ, "fmOversampling", json_integer(fmOversampling));
+        json_object_set_new(rootJ, "unison", json_integer(unison));
+        json_object_set_new(rootJ, "unisonStereo", json_boolean(unisonStereo));
+        return rootJ;
+    }
+
+    void dataFromJson(json_t *rootJ) override
+    {
+        json_t *engineJ = json_object_get(rootJ, "engine");
+        if (engineJ)
+            engine = clamp((int)json_integer_value(engineJ), 0, NUM_ENGINES - 1);
+        json_t *fmOversamplingJ = json_object_get(rootJ, "fmOversampling");
+        if (fmOversamplingJ)
+            fmOversampling = clamp((int)json_integer_value(fmOversamplingJ), 0, NUM_FM_OVERSAMPLINGS - 1);
+        json_t *unisonJ = json_object_get(rootJ, "unison");
+        if (unisonJ)
+            unison = clamp((int)json_integer_value(unisonJ), 0, NUM_UNISONS - 1);
+        json_t *unisonStereoJ = json_object_get(rootJ, "unisonStereo");
+        if (unisonStereoJ)
+            unisonStereo = json_boolean_value(unisonStereoJ);
     }
 };
 
@@ -453,6 +842,7 @@ struct ONAWidget : ModuleWidget
 
         addParam(createParamCentered<Trimpot>(mm2px(Vec(7.65, 66.75)), module, ONA::FM_PARAM));
         addParam(createParamCentered<Trimpot>(mm2px(Vec(32.5, 66.75)), module, ONA::PW_PARAM));
+        addParam(createParamCentered<Trimpot>(mm2px(Vec(20, 66.75)), module, ONA::UNISON_SPREAD_PARAM));
 
         addParam(createParamCentered<NANOComponents::BarkSwitchSmall2P>(mm2px(Vec(7.5, 37.0)), module, ONA::FM_SW_PARAM));
         addParam(createParamCentered<NANOComponents::BarkSwitchSmall2P>(mm2px(Vec(32.5, 37.0)), module, ONA::MODE_PARAM));
@@ -472,6 +862,27 @@ struct ONAWidget : ModuleWidget
         addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(25, 108.25)), module, ONA::SAW_OUTPUT));
         addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(35, 108.25)), module, ONA::PULSE_OUTPUT));
     }
+
+    void appendContextMenu(Menu *menu) override
+    {
+        ModuleWidget::appendContextMenu(menu);
+        ONA *module = dynamic_cast<ONA *>(this->module);
+        if (!module)
+            return;
+
+        menu->addChild(new MenuSeparator);
+        menu->addChild(createIndexPtrSubmenuItem("Band limiting", {"PolyBLEP", "Mipmapped wavetables"}, &module->engine));
+        menu->addChild(createIndexPtrSubmenuItem("Linear FM oversampling", {"Off", "2x", "4x"}, &module->fmOversampling));
+        //The oscillators run once per oversampled step, each patched output adds a decimator
+        if (module->activeOversampling > 1)
+            menu->addChild(createMenuLabel(string::f("Running at %dx, about %dx the oscillator cost", module->activeOversampling, module->activeOversampling)));
+        else if (module->fmOversampling != ONA::FM_OVERSAMPLING_OFF)
+            menu->addChild(createMenuLabel("Idle until linear FM is patched"));
+
+        menu->addChild(new MenuSeparator);
+        menu->addChild(createIndexPtrSubmenuItem("Unison", {"Off", "4 copies, up to 4 voices", "8 copies, up to 2 voices"}, &module->unison));
+        menu->addChild(createBoolPtrMenuItem("Unison stereo spread", "", &module->unisonStereo));
+    }
 };
 
-Model *modelONA = createModel<ONA, ONAWidget>("ONA");
\ No newline at end of file
+Model *modelONA = createModel<NANOTiming::Timed<ONA>, NANOTiming::TimedWidget<ONAWidget>>("ONA");
\ No newline at end of file
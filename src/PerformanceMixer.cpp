@@ -1,50 +1,125 @@
 #include "plugin.hpp"
 #include <componentlibrary.hpp>
 #include "NANOComponents.hpp"
+#include "NANOTiming.hpp"
+#include <atomic>
 #include "PerformanceMixer.hpp"
+#include "Resources/SynthTools/blockMeter.hpp"
+#include "Resources/SynthTools/channelInsert.hpp"
+#include "Resources/SynthTools/clipper.hpp"
+#include "Resources/SynthTools/lookupTables.hpp"
+#include "Resources/SynthTools/tableRegistry.hpp"
 
-#define LED_SMOOTHING 0.00005f
 #define SLEW_SMOOTHING 0.005f
 #define MIXER_CHANNELS 4
 #define MIXER_AUX 2
+#define MIXER_SCENES 8
 
+using simd::float_4;
+
+// The four channel strips run as one float_4, channel i in lane i
 struct PerformanceMixer : Module
 {   
-    float pot_vol[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
-    float pot_pan[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
-    float pot_aux[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
-    float l_input[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
-    float r_input[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
-    float l_output[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
-    float r_output[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
-    float cv_aux[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
-    float cv_vol[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
-    float cv_pan[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
-    float slewMute[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
-    float slewCue[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float_4 pot_vol = 0.0f;
+    float_4 pot_pan = 0.0f;
+    float_4 pot_aux = 0.0f;
+    float_4 l_input = 0.0f;
+    float_4 r_input = 0.0f;
+    float_4 l_output = 0.0f;
+    float_4 r_output = 0.0f;
+    float_4 cv_aux = 0.0f;
+    float_4 cv_vol = 0.0f;
+    float_4 cv_pan = 0.0f;
+    float_4 slewMute = 0.0f;
+    float_4 slewCue = 0.0f;
     bool isCued[MIXER_CHANNELS] = {false, false, false, false};
     bool isMuted[MIXER_CHANNELS] = {false, false, false, false};
     bool isGateMuted[MIXER_CHANNELS] = {false, false, false, false};
     bool isFinallyMuted[MIXER_CHANNELS] = {false, false, false, false};
     bool isPressed[MIXER_CHANNELS] = {false, false, false, false};    
     bool wasPressed[MIXER_CHANNELS] = {false, false, false, false};
-    bool sendtoX[MIXER_CHANNELS] = {false, false, false, false};
     bool prePost[MIXER_AUX] = {false, false};
     float gain_ret[MIXER_AUX] = {0.0f, 0.0f};
     float aux_ret_l[MIXER_AUX] = {0.0f, 0.0f};
     float aux_ret_r[MIXER_AUX] = {0.0f, 0.0f};
-    float mono_in[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
-    float gain_pre[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
-    float gain_L[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
-    float gain_R[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
-    float pan_pre[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
-    float aux_pre[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float_4 mono_in = 0.0f;
+    float_4 gain_pre = 0.0f;
+    float_4 pan_pre = 0.0f;
+    float_4 aux_pre = 0.0f;
+    float_4 pan_l = 0.0f;
+    float_4 pan_r = 0.0f;
     
     float mix_ret_l = 0.0f, mix_ret_r = 0.0f;
     float x_send = 0.0f, y_send = 0.0f;
     float mix_l = 0.0f, mix_r = 0.0f;
     float mix_cue = 0.0f;
 
+    // Gain of a poly cable on a channel input, by its voice count
+    enum PolyGains {
+        POLY_SUM,
+        POLY_AVERAGE,
+        POLY_EQUAL_POWER,
+        NUM_POLY_GAINS
+    };
+    int polyGain = POLY_SUM;
+    int activePolyGain = -1;
+    float voiceGain[PORT_MAX_CHANNELS + 1];
+
+    // CEQ style EQ and compressor inserts before the faders, all channels in one pass
+    bool insertOn[MIXER_CHANNELS] = {false, false, false, false};
+    ChannelInsert<float_4> insert_l;
+    ChannelInsert<float_4> insert_r;
+
+    // Master bus clipper, L and R in the first two lanes
+    enum MasterClips {
+        CLIP_OFF,
+        CLIP_SOFT,
+        CLIP_HARD,
+        NUM_MASTER_CLIPS
+    };
+    int masterClip = CLIP_OFF;
+    int activeMasterClip = CLIP_OFF;
+    AdaaClipper clipper;
+
+    int panLawIndex = PanLawTable::LAW_3DB;
+    int activePanLaw = -1;
+    // Pans the gains were last looked up for, they only change when a pan knob or CV moves
+    float_4 pan_last = -1.0f;
+
+    // Scene slots with the channel faders, pans, aux sends, mutes and cues. The slots are only
+    // written by the engine, the menu asks for a store or a recall through the atomics
+    struct Scene {
+        float_4 vol = 0.75f;
+        float_4 pan = 0.5f;
+        float_4 aux = 0.0f;
+        bool muted[MIXER_CHANNELS] = {false, false, false, false};
+        bool cued[MIXER_CHANNELS] = {false, false, false, false};
+        bool stored = false;
+    };
+    Scene scenes[MIXER_SCENES];
+    std::atomic<int> storeRequest{-1};
+    std::atomic<int> recallRequest{-1};
+    int morphTimeIndex = 3;
+    // Knob positions when the recall started and the slot being faded to, copied so storing
+    // into the slot during the fade does not change it
+    Scene morphFrom;
+    Scene morphTo;
+    bool morphing = false;
+    float morphPhase = 0.0f;
+    float morphRate = 0.0f;
+
+    // Menu option, cascade into a mixer on the right instead of running the master stage
+    bool cascadeOut = false;
+    // True while the mixer feeds a cascade on its right
+    bool feedsCascade = false;
+    // True while it runs the master stage for mixers cascaded on its left
+    bool mastersCascade = false;
+    // Own sums of the last samples, to line them up with a cascade bus that comes in late
+    static const int CASCADE_DELAY = 64;
+    MixerBus ownSums[CASCADE_DELAY];
+    int ownSumsPos = 0;
+    int cascadeDelay = 0;
+
     enum ParamIds
     {
         AUX1_PARAM,
@@ -74,6 +149,22 @@ struct PerformanceMixer : Module
         AUX_X_VOL_PARAM,
         AUX_Y_VOL_PARAM,
         MASTER_VOL_PARAM,
+        INSERT_LOW1_PARAM,
+        INSERT_LOW2_PARAM,
+        INSERT_LOW3_PARAM,
+        INSERT_LOW4_PARAM,
+        INSERT_MID1_PARAM,
+        INSERT_MID2_PARAM,
+        INSERT_MID3_PARAM,
+        INSERT_MID4_PARAM,
+        INSERT_HIGH1_PARAM,
+        INSERT_HIGH2_PARAM,
+        INSERT_HIGH3_PARAM,
+        INSERT_HIGH4_PARAM,
+        INSERT_COMP1_PARAM,
+        INSERT_COMP2_PARAM,
+        INSERT_COMP3_PARAM,
+        INSERT_COMP4_PARAM,
         NUM_PARAMS
     };
     enum InputIds
@@ -112,6 +203,7 @@ struct PerformanceMixer : Module
         Y_AUX_OUTPUT,
         CUE_OUTPUT,
         PHONES_OUTPUT,
+        METER_OUTPUT,
         NUM_OUTPUTS
     };
     enum LightIds {
@@ -130,11 +222,17 @@ struct PerformanceMixer : Module
 		NUM_LIGHTS
 	};
 
-    SharedData sharedData;
+    // Messages from EXP4 or a cascaded mixer, read one sample after they wrote them
+    ExpanderBuffers<ToMixerMessage> fromLeft;
+    // Channels pre fader in the lanes, the master L and R in the first two lanes of the other
+    BlockMeter channelMeter;
+    BlockMeter masterMeter;
+    std::shared_ptr<const PanLawTable> panLaw = TableRegistry::acquire<PanLawTable>();
 
     PerformanceMixer()
     {
         config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+        fromLeft.attach(leftExpander);
 
         // Config parameter ranges
         configParam(AUX1_PARAM, -1.0f, 1.f, 0.0f, "Channel 1 AUX Send");
@@ -172,6 +270,14 @@ struct PerformanceMixer : Module
         configSwitch(PRE_X_PARAM, 0.0f, 1.f, 0.0f, "Aux X PRE / POST", {"POST", "PRE"});
         configSwitch(PRE_Y_PARAM, 0.0f, 1.f, 0.0f, "Aux Y PRE / POST", {"POST", "PRE"});
 
+        // Insert controls live in the context menu, same ranges as CEQ
+        for(uint32_t i = 0; i < MIXER_CHANNELS; i++){
+            configParam(INSERT_LOW1_PARAM + i, 0.0f, 2.f, 1.0f, string::f("Channel %d Insert Low Gain", i + 1));
+            configParam(INSERT_MID1_PARAM + i, 0.0f, 2.f, 1.0f, string::f("Channel %d Insert Mid Gain", i + 1));
+            configParam(INSERT_HIGH1_PARAM + i, 0.0f, 2.f, 1.0f, string::f("Channel %d Insert High Gain", i + 1));
+            configParam(INSERT_COMP1_PARAM + i, 0.0f, 1.f, 0.0f, string::f("Channel %d Insert Compression", i + 1));
+        }
+
         configInput(L1_INPUT, "L1");
         configInput(L2_INPUT, "L2");
         configInput(L3_INPUT, "L3");
@@ -207,42 +313,149 @@ struct PerformanceMixer : Module
 
         configOutput(X_AUX_OUTPUT, "X Aux");
         configOutput(Y_AUX_OUTPUT, "Y Aux"); 
+        configOutput(METER_OUTPUT, "Meter, RMS of channels 1-4, L and R");
+    }
+
+    void onSampleRateChange(const SampleRateChangeEvent &e) override {
+        channelMeter.setSampleRate(e.sampleRate);
+        masterMeter.setSampleRate(e.sampleRate);
+        insert_l.setSampleRate(e.sampleRate);
+        insert_r.setSampleRate(e.sampleRate);
+    }
+
+    float_4 slew(float_4 in, float_4 out, float delta) {
+        return out + clamp(in - out, -delta, delta);
+    }
+
+    // Sum of the four channel lanes
+    static float sum(float_4 x) {
+        return (x[0] + x[1]) + (x[2] + x[3]);
     }
 
-    float slew(float in, float out, float delta) {
-        float error = (in)-out;
-        float d = (delta);
-        if (error > d) {
-            error = d;
-        } else if (error < -d) {
-            error = -d;
+    void updateVoiceGains() {
+        for (int n = 1; n <= PORT_MAX_CHANNELS; n++) {
+            if (polyGain == POLY_AVERAGE) voiceGain[n] = 1.0f / n;
+            else if (polyGain == POLY_EQUAL_POWER) voiceGain[n] = 1.0f / std::sqrt((float)n);
+            else voiceGain[n] = 1.0f;
+        }
+        voiceGain[0] = 1.0f;
+        activePolyGain = polyGain;
+    }
+
+    // The voices of a poly cable summed four at a time, lanes past the last voice masked off
+    float sumVoices(Input &input) {
+        int voices = input.getChannels();
+        if (voices <= 1) return input.getVoltage();
+        float_4 voice = float_4(0.0f, 1.0f, 2.0f, 3.0f);
+        float_4 acc = 0.0f;
+        for (int c = 0; c < voices; c += 4) {
+            acc += ifelse(voice < (float)(voices - c), input.getVoltageSimd<float_4>(c), 0.0f);
+        }
+        return sum(acc) * voiceGain[voices];
+    }
+
+    // Crossfade times of the scene recall, in seconds
+    static float morphTime(int index) {
+        static const float times[] = {0.0f, 0.1f, 0.5f, 1.0f, 2.0f, 5.0f, 10.0f};
+        return times[clamp(index, 0, 6)];
+    }
+
+    // The scene the panel is showing now
+    void captureScene(Scene &scene) {
+        for(uint32_t i = 0; i < MIXER_CHANNELS; i++){
+            scene.vol[i] = params[VOL1_PARAM + i].getValue();
+            scene.pan[i] = params[PAN1_PARAM + i].getValue();
+            scene.aux[i] = params[AUX1_PARAM + i].getValue();
+            scene.muted[i] = isMuted[i];
+            scene.cued[i] = params[CUE1_PARAM + i].getValue() < 0.5f;
+        }
+        scene.stored = true;
+    }
+
+    void startMorph(int slot, float sampleTime) {
+        captureScene(morphFrom);
+        morphTo = scenes[slot];
+        float time = morphTime(morphTimeIndex);
+        morphRate = time > 0.0f ? sampleTime / time : 1.0f;
+        morphPhase = 0.0f;
+        morphing = true;
+
+        // Channels that come in or get cued switch at the start, so they fade in with their
+        // fader. The ones that go out keep playing until the end
+        for(uint32_t i = 0; i < MIXER_CHANNELS; i++){
+            if (!morphTo.muted[i]) isMuted[i] = false;
+            if (morphTo.cued[i]) params[CUE1_PARAM + i].setValue(0.0f);
         }
-        out += error;
-        return out;
+    }
+
+    // Moves the knobs one sample further, the strips then read them as if turned by hand
+    void stepMorph() {
+        morphPhase = std::fmin(morphPhase + morphRate, 1.0f);
+        // The last step lands on the stored values, the blend can round off them
+        bool done = morphPhase >= 1.0f;
+        float_4 vol = done ? morphTo.vol : morphFrom.vol + (morphTo.vol - morphFrom.vol) * morphPhase;
+        float_4 pan = done ? morphTo.pan : morphFrom.pan + (morphTo.pan - morphFrom.pan) * morphPhase;
+        float_4 aux = done ? morphTo.aux : morphFrom.aux + (morphTo.aux - morphFrom.aux) * morphPhase;
+        for(uint32_t i = 0; i < MIXER_CHANNELS; i++){
+            params[VOL1_PARAM + i].setValue(vol[i]);
+            params[PAN1_PARAM + i].setValue(pan[i]);
+            params[AUX1_PARAM + i].setValue(aux[i]);
+        }
+        if (!done) return;
+
+        for(uint32_t i = 0; i < MIXER_CHANNELS; i++){
+            isMuted[i] = morphTo.muted[i];
+            params[CUE1_PARAM + i].setValue(morphTo.cued[i] ? 0.0f : 1.0f);
+        }
+        morphing = false;
     }
 
     void process(const ProcessArgs &args) override
     {
-        // Read voltage inputs
+        // Scene requests from the menu
+        if (storeRequest.load(std::memory_order_relaxed) >= 0) {
+            int slot = storeRequest.exchange(-1);
+            if (slot >= 0) captureScene(scenes[slot]);
+        }
+        if (recallRequest.load(std::memory_order_relaxed) >= 0) {
+            int slot = recallRequest.exchange(-1);
+            if (slot >= 0 && scenes[slot].stored) startMorph(slot, args.sampleTime);
+        }
+        if (morphing) stepMorph();
+
+        if (polyGain != activePolyGain) updateVoiceGains();
+
+        // Read voltage inputs, one lane per channel. Poly cables are summed
         for(uint32_t i = 0; i < MIXER_CHANNELS; i++){
-            l_input[i] = inputs[i].getVoltage();
+            l_input[i] = sumVoices(inputs[i]);
             // Check if we have to normalize L to R on Stereo Inputs
-            if(inputs[R1_INPUT + i].isConnected()){
-                r_input[i] = inputs[R1_INPUT + i].getVoltage();
-            } else {
-                r_input[i] = l_input[i];
-            }
-            mono_in[i] = (l_input[i] + r_input[i]) / 2.0f;
+            r_input[i] = inputs[R1_INPUT + i].isConnected() ? sumVoices(inputs[R1_INPUT + i]) : l_input[i];
+
+            // Do CV signals normalization if required and save the CV values
+            cv_vol[i] = inputs[CV_VOL_1 + i].isConnected() ? inputs[CV_VOL_1 + i].getVoltage() : 5.0f;
+            cv_pan[i] = inputs[CV_PAN_1 + i].getVoltage();
+
+            pot_vol[i] = params[VOL1_PARAM + i].getValue();
+            pot_pan[i] = params[PAN1_PARAM + i].getValue();
+            pot_aux[i] = params[AUX1_PARAM + i].getValue();
         }
 
-        // Do CV signals normalization if required and save the CV values
+        // Run the inserts on every lane while any of them is on, so a lane switched on later
+        // starts from filters and an envelope that already follow its signal
+        float_4 insertMask = 0.0f;
         for(uint32_t i = 0; i < MIXER_CHANNELS; i++){
-            if(inputs[CV_VOL_1 + i].isConnected()){
-                cv_vol[i] = inputs[CV_VOL_1 + i].getVoltage();
-            } else {
-                cv_vol[i] = 5.0f;
+            insertMask[i] = insertOn[i] ? 1.0f : 0.0f;
+        }
+        if (simd::movemask(insertMask > 0.0f)) {
+            float_4 low, mid, high, comp;
+            for(uint32_t i = 0; i < MIXER_CHANNELS; i++){
+                low[i] = params[INSERT_LOW1_PARAM + i].getValue();
+                mid[i] = params[INSERT_MID1_PARAM + i].getValue();
+                high[i] = params[INSERT_HIGH1_PARAM + i].getValue();
+                comp[i] = params[INSERT_COMP1_PARAM + i].getValue();
             }
-            cv_pan[i] = inputs[CV_PAN_1 + i].getVoltage();
+            l_input = ifelse(insertMask > 0.0f, insert_l.process(l_input, low, mid, high, comp), l_input);
+            r_input = ifelse(insertMask > 0.0f, insert_r.process(r_input, low, mid, high, comp), r_input);
         }
 
         // Read voltage inputs
@@ -260,6 +473,20 @@ struct PerformanceMixer : Module
         cv_aux[0] = inputs[CV_AUX_1].getVoltage();
         cv_aux[1] = inputs[CV_AUX_2].getVoltage();
 
+        // Check if an expander or a mixer is connected on the left
+        bool expanderConnected = leftExpander.module && (leftExpander.module->model == modelEXP4);
+        bool mixerConnected = leftExpander.module && (leftExpander.module->model == modelPerformanceMixer);
+
+        // Mute gates and aux CVs of channels 3 and 4 come from the expander
+        const ToMixerMessage *fromExp4 = (const ToMixerMessage*) leftExpander.consumerMessage;
+        // Only a mixer that cascades marks its bus, an EXP4 relays it as it is
+        bool cascadeConnected = (expanderConnected || mixerConnected) && fromExp4->bus.cascaded;
+        for(uint32_t i = 0; i < MIXER_CHANNELS; i++){
+            isGateMuted[i] = expanderConnected && fromExp4->gateMuted[i];
+        }
+        cv_aux[2] = expanderConnected ? fromExp4->cv_aux[2] : 0.0f;
+        cv_aux[3] = expanderConnected ? fromExp4->cv_aux[3] : 0.0f;
+
         for(uint32_t i = 0; i < MIXER_AUX; i++){
             prePost[i] = !params[PRE_X_PARAM + i].getValue();
             gain_ret[i] = params[AUX_X_VOL_PARAM + i].getValue();
@@ -268,6 +495,7 @@ struct PerformanceMixer : Module
         }
 
         // Check MUTE & CUE state on buttons
+        float_4 unmuted, cued;
         for(uint32_t i = 0; i < MIXER_CHANNELS; i++){
             // Read the actual CUE button state
             isCued[i] = (bool)!(params[(CUE1_PARAM + i)].getValue() > 0.5f);
@@ -280,60 +508,118 @@ struct PerformanceMixer : Module
             } 
             // Update the state for the next process call
             wasPressed[i] = isPressed[i];
-        }
-        for(uint32_t i = 0; i < MIXER_CHANNELS; i++){
+
             // Compute final mute value
             isFinallyMuted[i] = !isMuted[i] & !isGateMuted[i];
-
-            // Write the MUTE LEDs state
-            lights[MUTE1_LIGHT + i].setSmoothBrightness(!isFinallyMuted[i], LED_SMOOTHING);
-
-            // Add slew to the MUTE and CUE params
-            slewMute[i] = slew((float)isFinallyMuted[i], slewMute[i], SLEW_SMOOTHING);
-            slewCue[i] = slew((float)isCued[i], slewCue[i], SLEW_SMOOTHING);
-        }
-
-        // Get channel main parameters
-        for(uint32_t i = 0; i < MIXER_CHANNELS; i++){
-            gain_pre[i] = clamp((params[VOL1_PARAM + i].getValue() * (cv_vol[i] / 5.0f)) * slewMute[i], 0.0f, 1.0f);
-            pan_pre[i] = clamp((params[PAN1_PARAM + i].getValue() + (cv_pan[i] / 5.0f)), 0.0f, 1.0f);
-            aux_pre[i] = clamp((params[AUX1_PARAM + i].getValue() + (cv_aux[i] / 5.0f)), -1.0f, 1.0f);
+            unmuted[i] = (float)isFinallyMuted[i];
+            cued[i] = (float)isCued[i];
         }
 
-        // Compute channel send
-        for (uint32_t i = 0; i < MIXER_CHANNELS; i++){
-            // Determine the routing for the auxiliary signal based on its voltage.
-            if(aux_pre[i] >= 0.0f) sendtoX[i] = false; else sendtoX[i] = true;
-            if(prePost[0] == 0) x_send += (mono_in[i] * fabsf(aux_pre[i]) * static_cast<float>(sendtoX[i]));  else x_send += (mono_in[i] * fabsf(aux_pre[i]) * gain_pre[i] * static_cast<float>(sendtoX[i]));
-            if(prePost[1] == 0) y_send += (mono_in[i] * fabsf(aux_pre[i]) * static_cast<float>(!sendtoX[i])); else y_send += (mono_in[i] * fabsf(aux_pre[i]) * gain_pre[i] * static_cast<float>(!sendtoX[i]));
-        }
+        // Add slew to the MUTE and CUE params
+        slewMute = slew(unmuted, slewMute, SLEW_SMOOTHING);
+        slewCue = slew(cued, slewCue, SLEW_SMOOTHING);
 
-        // Write the AUX output voltages
-        outputs[X_AUX_OUTPUT].setVoltage(x_send);
-        outputs[Y_AUX_OUTPUT].setVoltage(y_send);
+        // Get channel main parameters
+        mono_in = (l_input + r_input) * 0.5f;
+        gain_pre = clamp((pot_vol * (cv_vol / 5.0f)) * slewMute, 0.0f, 1.0f);
+        pan_pre = clamp(pot_pan + (cv_pan / 5.0f), 0.0f, 1.0f);
+        aux_pre = clamp(pot_aux + (cv_aux / 5.0f), -1.0f, 1.0f);
+
+        // Compute channel send, negative aux settings go to X and positive ones to Y
+        float_4 sendtoX = aux_pre < 0.0f;
+        float_4 send = mono_in * simd::abs(aux_pre);
+        float_4 post = send * gain_pre;
+        x_send += sum(ifelse(sendtoX, prePost[0] ? post : send, 0.0f));
+        y_send += sum(ifelse(sendtoX, 0.0f, prePost[1] ? post : send));
 
         // Compute channel master & cue mix
-        for (uint32_t i = 0; i < MIXER_CHANNELS; i++){
-            l_output[i] = (l_input[i] * gain_pre[i]) * cosf(pan_pre[i] * M_PI_2);
-            r_output[i] = (r_input[i] * gain_pre[i]) * sinf(pan_pre[i] * M_PI_2);
-            mix_l += l_output[i];
-            mix_r += r_output[i];
-            mix_cue += mono_in[i] * slewCue[i];
+        if (simd::movemask(pan_pre != pan_last) || panLawIndex != activePanLaw) {
+            panLaw->gains(panLawIndex, pan_pre, pan_l, pan_r);
+            pan_last = pan_pre;
+            activePanLaw = panLawIndex;
         }
+        l_output = (l_input * gain_pre) * pan_l;
+        r_output = (r_input * gain_pre) * pan_r;
+        mix_l += sum(l_output);
+        mix_r += sum(r_output);
+        mix_cue += sum(mono_in * slewCue);
 
         // Sum returns to the master channel mix
         mix_l += mix_ret_l;
         mix_r += mix_ret_r;
 
+        // Add the sums of the mixers cascaded on the left to the own ones from as many samples
+        // ago as they lag. The delay line is always written so it holds no stale sums
+        MixerBus &own = ownSums[ownSumsPos];
+        own.l = mix_l;
+        own.r = mix_r;
+        own.cue = mix_cue;
+        own.x = x_send;
+        own.y = y_send;
+        cascadeDelay = cascadeConnected ? clamp(fromExp4->bus.latency + (expanderConnected ? 2 : 1), 0, CASCADE_DELAY - 1) : 0;
+        if (cascadeConnected) {
+            const MixerBus &delayed = ownSums[(ownSumsPos - cascadeDelay) & (CASCADE_DELAY - 1)];
+            mix_l = delayed.l + fromExp4->bus.l;
+            mix_r = delayed.r + fromExp4->bus.r;
+            mix_cue = delayed.cue + fromExp4->bus.cue;
+            x_send = delayed.x + fromExp4->bus.x;
+            y_send = delayed.y + fromExp4->bus.y;
+        }
+        ownSumsPos = (ownSumsPos + 1) & (CASCADE_DELAY - 1);
+
+        // Pass the sums on when cascading into the next mixer on the right, adjacent or behind
+        // its EXP4. Without cascading it still gets a bus, unmarked so it keeps to its own sums
+        Module *next = rightExpander.module;
+        bool nextIsMixer = next && (next->model == modelPerformanceMixer);
+        bool nextIsExpander = next && (next->model == modelEXP4) && next->rightExpander.module && (next->rightExpander.module->model == modelPerformanceMixer);
+        feedsCascade = cascadeOut && (nextIsMixer || nextIsExpander);
+        mastersCascade = !feedsCascade && cascadeConnected;
+        if (nextIsMixer || nextIsExpander) {
+            MixerBus *bus = nextIsMixer ? &((ToMixerMessage*) next->leftExpander.producerMessage)->bus : (MixerBus*) next->leftExpander.producerMessage;
+            *bus = MixerBus();
+            if (feedsCascade) {
+                bus->cascaded = true;
+                bus->latency = cascadeDelay;
+                bus->l = mix_l;
+                bus->r = mix_r;
+                bus->cue = mix_cue;
+                bus->x = x_send;
+                bus->y = y_send;
+            }
+            next->leftExpander.requestMessageFlip();
+        }
+        if (feedsCascade) {
+            // Only the last mixer of the cascade runs the master stage
+            mix_l = 0.0f;
+            mix_r = 0.0f;
+            mix_cue = 0.0f;
+            x_send = 0.0f;
+            y_send = 0.0f;
+        }
+
+        // Write the AUX output voltages
+        outputs[X_AUX_OUTPUT].setVoltage(x_send);
+        outputs[Y_AUX_OUTPUT].setVoltage(y_send);
+
         // Read master volume knob
         float masterVol = params[MASTER_VOL_PARAM].getValue();
 
         float phonesVol = params[PHONES_VOL_PARAM].getValue();
         float phonesMix = params[PHONES_MIX_PARAM].getValue();
 
+        // Clip the master bus at 10 V if enabled
+        float_4 master = float_4(mix_l, mix_r, 0.0f, 0.0f) * masterVol;
+        float_4 masterOut = master;
+        if (masterClip != CLIP_OFF) {
+            int shape = (masterClip == CLIP_SOFT) ? AdaaClipper::SOFT : AdaaClipper::HARD;
+            if (masterClip != activeMasterClip) clipper.reset(master, 10.0f, shape);
+            masterOut = clipper.process(master, 10.0f, shape);
+        }
+        activeMasterClip = masterClip;
+
         // Write the output voltages
-        outputs[L_OUTPUT].setVoltage(mix_l * masterVol);
-        outputs[R_OUTPUT].setVoltage(mix_r * masterVol);
+        outputs[L_OUTPUT].setVoltage(masterOut[0]);
+        outputs[R_OUTPUT].setVoltage(masterOut[1]);
 
         outputs[CUE_OUTPUT].setVoltage(mix_cue);
         // Set the number of channels for the STEREO_OUTPUT to 2 (for stereo)
@@ -341,47 +627,39 @@ struct PerformanceMixer : Module
         outputs[PHONES_OUTPUT].setVoltage(((1.0f - phonesMix) * mix_cue) + (mix_l * phonesMix) * phonesVol, 0); 
         outputs[PHONES_OUTPUT].setVoltage(((1.0f - phonesMix) * mix_cue) + (mix_r * phonesMix) * phonesVol, 1); 
 
-        // Set the fader LEDs brightness depending on channel signal
-        for(uint32_t i = 0; i < MIXER_CHANNELS; i++){
-            lights[VOL1_LIGHT + i].setSmoothBrightness(mono_in[i] / 1.0, LED_SMOOTHING);
-        }
-
-        // Set the LEDs brightness depending on output signal
-        lights[L_LIGHT].setSmoothBrightness(mix_l / 5.0, LED_SMOOTHING);
-        lights[R_LIGHT].setSmoothBrightness(mix_r / 5.0, LED_SMOOTHING);
-
-        // Use a comparator for the clip leds
-        if(abs(mix_l) > 10.0f){
-            lights[CLIPL_LIGHT].setSmoothBrightness(1.0f, LED_SMOOTHING);
-        } else {
-            lights[CLIPL_LIGHT].setSmoothBrightness(0.0f, LED_SMOOTHING);
-        }
+        // Meter every sample, the lights and the meter CVs only change once per block.
+        // Both meters run in step, so their blocks end on the same sample
+        channelMeter.process(mono_in);
+        // The master meter sees the bus before the clipper, so the clip LEDs show where it works
+        if (masterMeter.process(master)) {
+            float blockTime = masterMeter.blockTime;
+            for(uint32_t i = 0; i < MIXER_CHANNELS; i++){
+                // Set the fader LEDs brightness depending on channel signal
+                lights[VOL1_LIGHT + i].setBrightnessSmooth(channelMeter.rms[i] / 5.0f, blockTime);
+                lights[MUTE1_LIGHT + i].setBrightnessSmooth(!isFinallyMuted[i], blockTime);
+            }
 
-        if(abs(mix_r) > 10.0f){
-            lights[CLIPR_LIGHT].setSmoothBrightness(1.0f, LED_SMOOTHING);
-        } else {
-            lights[CLIPR_LIGHT].setSmoothBrightness(0.0f, LED_SMOOTHING);
+            // Set the LEDs brightness depending on output signal
+            lights[L_LIGHT].setBrightnessSmooth(masterMeter.rms[0] / 5.0f, blockTime);
+            lights[R_LIGHT].setBrightnessSmooth(masterMeter.rms[1] / 5.0f, blockTime);
+            // The clip LEDs follow the held peak, so a single clipped sample stays visible
+            lights[CLIPL_LIGHT].setBrightness(masterMeter.peak[0] > 10.0f);
+            lights[CLIPR_LIGHT].setBrightness(masterMeter.peak[1] > 10.0f);
+
+            if (outputs[METER_OUTPUT].isConnected()) {
+                outputs[METER_OUTPUT].setChannels(MIXER_CHANNELS + 2);
+                outputs[METER_OUTPUT].setVoltageSimd(channelMeter.rms, 0);
+                outputs[METER_OUTPUT].setVoltage(masterMeter.rms[0], MIXER_CHANNELS);
+                outputs[METER_OUTPUT].setVoltage(masterMeter.rms[1], MIXER_CHANNELS + 1);
+            }
         }
 
-        // Check if an expander is connected
-        bool expanderConnected = leftExpander.module && (leftExpander.module->model == modelEXP4);
-
         if (expanderConnected) {
-            // Example: use data from the expander
-
-                // Read or write to sharedData as needed
-                for(uint32_t i = 0; i < MIXER_CHANNELS; i++){
-                    // Read the shared data
-                    sharedData.shared_l_output[i] = l_output[i];
-                    sharedData.shared_r_output[i] = r_output[i];
-                    isGateMuted[i] = sharedData.shared_gateMuted[i];
-                }
-
-                cv_aux[2] = sharedData.shared_cv_aux[2];
-                cv_aux[3] = sharedData.shared_cv_aux[3];
-
-                // Set the shared data for the expander to read
-                leftExpander.producerMessage = &sharedData;
+            // Send the post fader channels to the expander's direct outs
+            MixerToExpanderMessage *toExp4 = (MixerToExpanderMessage*) leftExpander.module->rightExpander.producerMessage;
+            l_output.store(toExp4->l_output);
+            r_output.store(toExp4->r_output);
+            leftExpander.module->rightExpander.requestMessageFlip();
         }
 
     // Rest of your processing code
@@ -411,6 +689,46 @@ struct PerformanceMixer : Module
         // Add the mutedArray to the root object
         json_object_set_new(rootJ, "isFinallyMuted", mutedArray);
 
+        // One object per scene slot, the empty ones only say so
+        json_t* scenesArray = json_array();
+        for (int s = 0; s < MIXER_SCENES; ++s) {
+            const Scene &scene = scenes[s];
+            json_t* sceneJ = json_object();
+            json_object_set_new(sceneJ, "stored", json_boolean(scene.stored));
+            if (scene.stored) {
+                json_t* volJ = json_array();
+                json_t* panJ = json_array();
+                json_t* auxJ = json_array();
+                json_t* mutedJ = json_array();
+                json_t* cuedJ = json_array();
+                for (int i = 0; i < MIXER_CHANNELS; ++i) {
+                    json_array_append_new(volJ, json_real(scene.vol[i]));
+                    json_array_append_new(panJ, json_real(scene.pan[i]));
+                    json_array_append_new(auxJ, json_real(scene.aux[i]));
+                    json_array_append_new(mutedJ, json_boolean(scene.muted[i]));
+                    json_array_append_new(cuedJ, json_boolean(scene.cued[i]));
+                }
+                json_object_set_new(sceneJ, "vol", volJ);
+                json_object_set_new(sceneJ, "pan", panJ);
+                json_object_set_new(sceneJ, "aux", auxJ);
+                json_object_set_new(sceneJ, "muted", mutedJ);
+                json_object_set_new(sceneJ, "cued", cuedJ);
+            }
+            json_array_append_new(scenesArray, sceneJ);
+        }
+        json_object_set_new(rootJ, "scenes", scenesArray);
+        json_object_set_new(rootJ, "sceneMorphTime", json_integer(morphTimeIndex));
+        json_object_set_new(rootJ, "polyGain", json_integer(polyGain));
+        json_object_set_new(rootJ, "panLaw", json_integer(panLawIndex));
+        json_object_set_new(rootJ, "masterClip", json_integer(masterClip));
+        json_object_set_new(rootJ, "cascadeOut", json_boolean(cascadeOut));
+
+        json_t* insertArray = json_array();
+        for (int i = 0; i < MIXER_CHANNELS; ++i) {
+            json_array_append_new(insertArray, json_boolean(insertOn[i]));
+        }
+        json_object_set_new(rootJ, "insertOn", insertArray);
+
         return rootJ;
 }
 
@@ -424,6 +742,59 @@ struct PerformanceMixer : Module
                     isMuted[i] = json_boolean_value(mutedValue);
             }
         }
+        json_t* scenesArray = json_object_get(rootJ, "scenes");
+        if (scenesArray) {
+            for (int s = 0; s < MIXER_SCENES; ++s) {
+                json_t* sceneJ = json_array_get(scenesArray, s);
+                if (!sceneJ)
+                    continue;
+                Scene scene;
+                json_t* storedJ = json_object_get(sceneJ, "stored");
+                scene.stored = storedJ && json_boolean_value(storedJ);
+                json_t* volJ = json_object_get(sceneJ, "vol");
+                json_t* panJ = json_object_get(sceneJ, "pan");
+                json_t* auxJ = json_object_get(sceneJ, "aux");
+                json_t* mutedJ = json_object_get(sceneJ, "muted");
+                json_t* cuedJ = json_object_get(sceneJ, "cued");
+                for (int i = 0; i < MIXER_CHANNELS; ++i) {
+                    json_t* value;
+                    if (volJ && (value = json_array_get(volJ, i)))
+                        scene.vol[i] = json_number_value(value);
+                    if (panJ && (value = json_array_get(panJ, i)))
+                        scene.pan[i] = json_number_value(value);
+                    if (auxJ && (value = json_array_get(auxJ, i)))
+                        scene.aux[i] = json_number_value(value);
+                    if (mutedJ && (value = json_array_get(mutedJ, i)))
+                        scene.muted[i] = json_boolean_value(value);
+                    if (cuedJ && (value = json_array_get(cuedJ, i)))
+                        scene.cued[i] = json_boolean_value(value);
+                }
+                scenes[s] = scene;
+            }
+        }
+        json_t* morphTimeJ = json_object_get(rootJ, "sceneMorphTime");
+        if (morphTimeJ)
+            morphTimeIndex = clamp((int)json_integer_value(morphTimeJ), 0, 6);
+        json_t* polyGainJ = json_object_get(rootJ, "polyGain");
+        if (polyGainJ)
+            polyGain = clamp((int)json_integer_value(polyGainJ), 0, NUM_POLY_GAINS - 1);
+        json_t* panLawJ = json_object_get(rootJ, "panLaw");
+        if (panLawJ)
+            panLawIndex = clamp((int)json_integer_value(panLawJ), 0, PanLawTable::NUM_LAWS - 1);
+        json_t* masterClipJ = json_object_get(rootJ, "masterClip");
+        if (masterClipJ)
+            masterClip = clamp((int)json_integer_value(masterClipJ), 0, NUM_MASTER_CLIPS - 1);
+        json_t* cascadeOutJ = json_object_get(rootJ, "cascadeOut");
+        if (cascadeOutJ)
+            cascadeOut = json_boolean_value(cascadeOutJ);
+        json_t* insertArray = json_object_get(rootJ, "insertOn");
+        if (insertArray) {
+            for (int i = 0; i < MIXER_CHANNELS; ++i) {
+                json_t* insertValue = json_array_get(insertArray, i);
+                if (insertValue)
+                    insertOn[i] = json_boolean_value(insertValue);
+            }
+        }
 }
 
 };
@@ -452,8 +823,8 @@ struct PerformanceMixerWidget : ModuleWidget
 
         addParam(createParamCentered<Davies1900hWhiteKnob>(mm2px(Vec(128.75, 44.5)), module, PerformanceMixer::PHONES_VOL_PARAM));
         addParam(createParamCentered<Davies1900hBlackKnob>(mm2px(Vec(128.75, 65.0)), module, PerformanceMixer::PHONES_MIX_PARAM));
-        addParam(createParamCentered<Davies1900hBlackKnob>(mm2px(Vec(102.5, 85.5)), module, PerformanceMixer::AUX_X_VOL_PARAM)); 
-        addParam(createParamCentered<Davies1900hBlackKnob>(mm2px(Vec(102.5, 106.0)), module, PerformanceMixer::AUX_Y_VOL_PARAM));   
+        addParam(createParamCentered<Davies1900hBlackKnob>(mm2px(Vec(102.5, 81.0)), module, PerformanceMixer::AUX_X_VOL_PARAM)); 
+        addParam(createParamCentered<Davies1900hBlackKnob>(mm2px(Vec(102.5, 99.5)), module, PerformanceMixer::AUX_Y_VOL_PARAM));   
         addParam(createParamCentered<Davies1900hLargeBlackKnob>(mm2px(Vec(129.0, 102.0)), module, PerformanceMixer::MASTER_VOL_PARAM));       
 
         addParam(createLightParamCentered<LEDSliderRed>(mm2px(Vec(16.25, 95.5)), module, PerformanceMixer::VOL1_PARAM, PerformanceMixer::VOL1_LIGHT));
@@ -516,12 +887,67 @@ struct PerformanceMixerWidget : ModuleWidget
 
         addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(97.50, 14.50)), module, PerformanceMixer::X_AUX_OUTPUT));
         addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(107.50, 14.50)), module, PerformanceMixer::Y_AUX_OUTPUT));        
+        addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(97.50, 114.00)), module, PerformanceMixer::METER_OUTPUT));
 
         addChild(createLightCentered<MediumLight<WhiteLight>>(mm2px(Vec(122.75, 85.25)), module, PerformanceMixer::L_LIGHT));
         addChild(createLightCentered<MediumLight<WhiteLight>>(mm2px(Vec(134.75, 85.25)), module, PerformanceMixer::R_LIGHT));
         addChild(createLightCentered<MediumLight<RedLight>>(mm2px(Vec(122.75, 80.5)), module, PerformanceMixer::CLIPL_LIGHT));
         addChild(createLightCentered<MediumLight<RedLight>>(mm2px(Vec(134.75, 80.5)), module, PerformanceMixer::CLIPR_LIGHT));
     }
+
+    void appendContextMenu(Menu *menu) override
+    {
+        ModuleWidget::appendContextMenu(menu);
+        PerformanceMixer *module = dynamic_cast<PerformanceMixer *>(this->module);
+        if (!module)
+            return;
+
+        menu->addChild(new MenuSeparator);
+        menu->addChild(createIndexPtrSubmenuItem("Master clipper", {"Off", "Soft clip at 10 V", "Hard clip at 10 V"}, &module->masterClip));
+        menu->addChild(createIndexPtrSubmenuItem("Pan law", {"-3 dB, equal power", "-4.5 dB", "-6 dB, linear", "0 dB, linear balance"}, &module->panLawIndex));
+        // The insert controls have no panel space, their params are edited from here
+        for (int i = 0; i < MIXER_CHANNELS; i++) {
+            menu->addChild(createSubmenuItem(string::f("Channel %d insert", i + 1), module->insertOn[i] ? "On" : "Off", [=](Menu *menu) {
+                menu->addChild(createBoolPtrMenuItem("EQ and compressor", "", &module->insertOn[i]));
+                const int ids[4] = {PerformanceMixer::INSERT_LOW1_PARAM, PerformanceMixer::INSERT_MID1_PARAM, PerformanceMixer::INSERT_HIGH1_PARAM, PerformanceMixer::INSERT_COMP1_PARAM};
+                for (int id : ids) {
+                    ui::Slider *slider = new ui::Slider;
+                    slider->quantity = module->paramQuantities[id + i];
+                    slider->box.size.x = 200.0f;
+                    menu->addChild(slider);
+                }
+            }));
+        }
+        menu->addChild(createSubmenuItem("Scenes", "", [=](Menu *menu) {
+            for (int s = 0; s < MIXER_SCENES; s++) {
+                bool stored = module->scenes[s].stored;
+                menu->addChild(createMenuItem(string::f("Recall scene %d", s + 1), stored ? "" : "empty", [=]() {
+                    module->recallRequest = s;
+                }, !stored));
+            }
+            menu->addChild(new MenuSeparator);
+            for (int s = 0; s < MIXER_SCENES; s++) {
+                menu->addChild(createMenuItem(string::f("Store scene %d", s + 1), "", [=]() {
+                    module->storeRequest = s;
+                }));
+            }
+            menu->addChild(new MenuSeparator);
+            menu->addChild(createIndexPtrSubmenuItem("Crossfade time", {"Instant", "100 ms", "500 ms", "1 s", "2 s", "5 s", "10 s"}, &module->morphTimeIndex));
+        }));
+        menu->addChild(createIndexPtrSubmenuItem("Poly inputs", {"Sum the voices", "Average the voices", "Equal power, 1/sqrt(voices)"}, &module->polyGain));
+
+        // Cascades are built by placing mixers side by side and switching it on in all but the
+        // last one on the right, which is the master
+        menu->addChild(new MenuSeparator);
+        menu->addChild(createBoolPtrMenuItem("Cascade into the mixer on the right", "", &module->cascadeOut));
+        if (module->feedsCascade)
+            menu->addChild(createMenuLabel("Cascaded into the next mixer, master and phones off"));
+        else if (module->mastersCascade)
+            menu->addChild(createMenuLabel("Master of the mixers cascaded on the left"));
+        // One sample per hop from mixer to mixer, two through an EXP4
+        if (module->cascadeDelay > 0)
+            menu->addChild(createMenuLabel(string::f("Own channels delayed %d samples to line up with the cascade", module->cascadeDelay)));
+    }
 };
 
-Model *modelPerformanceMixer = createModel<PerformanceMixer, PerformanceMixerWidget>("PerformanceMixer");
\ No newline at end of file
+Model *modelPerformanceMixer = createModel<NANOTiming::Timed<PerformanceMixer>, NANOTiming::TimedWidget<PerformanceMixerWidget>>("PerformanceMixer");
\ No newline at end of file
@@ -4,16 +4,63 @@
 #define PERFORMANCE_MIXER_HPP
 
 #define MIXER_CHANNELS 4
+#define CACHE_LINE 64
 
-struct SharedData {
-    // Shared data between the module and expander 
-    float shared_l_output[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
-    float shared_r_output[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
+// Messages between mixers and EXP4s, an expander sits on the left of its mixer.
+// The receiving module owns both buffers of its side. The sender writes the producer message
+// and requests the flip, Rack swaps the buffers once every module ran for the sample and the
+// receiver reads its consumer message, so every message arrives exactly one sample later.
 
-    float shared_cv_aux[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
+// Mixers cascade from left to right, each one adds its sums before the master stage to the
+// ones it got from its left and passes them on. Only the last one runs the master stage.
+// Between two mixers with an EXP4 in the middle the expander relays the sums. Cascading is
+// switched on per mixer, one that is not cascading sends a bus that is not marked cascaded.
+//
+// Every hop costs latency, one sample from mixer to mixer and two through an EXP4, which reads
+// the bus one sample after the mixer wrote it and passes it on for the next. Each mixer delays
+// its own sums by the latency of the bus it gets, so all channels reach the master in step,
+// and tells the next one the latency of what it sends.
+struct MixerBus {
+    bool cascaded = false;
+    // Samples the sums lag the channels of the sending mixer
+    int latency = 0;
+    float l = 0.0f;
+    float r = 0.0f;
+    float cue = 0.0f;
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
+// Mixer to EXP4, the post fader channels for the direct outs
+struct MixerToExpanderMessage {
+    float l_output[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float r_output[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
+};
+
+// To a mixer from its left. EXP4 sends the mute gates and the aux CVs of channels 3 and 4,
+// the bus comes from a mixer on the left or is relayed by the EXP4
+struct ToMixerMessage {
+    float cv_aux[MIXER_CHANNELS] = {0.0f, 0.0f, 0.0f, 0.0f};
+    bool gateMuted[MIXER_CHANNELS] = {false, false, false, false};
+    MixerBus bus;
+};
+
+// Double buffer of one side. The padding keeps the buffer being written by the neighbour
+// off the cache lines of the one being read and of the module's own state, so two engine
+// threads never write to the same line
+template <typename TMessage>
+struct ExpanderBuffers {
+    char padding0[CACHE_LINE];
+    TMessage producer;
+    char padding1[CACHE_LINE];
+    TMessage consumer;
+    char padding2[CACHE_LINE];
 
-    bool shared_gateMuted[MIXER_CHANNELS] = {false, false, false, false};
-    // You can add more fields as needed
+    template <typename TExpander>
+    void attach(TExpander &expander) {
+        expander.producerMessage = &producer;
+        expander.consumerMessage = &consumer;
+    }
 };
 
-#endif // PERFORMANCE_MIXER_HPP
\ No newline at end of file
+#endif // PERFORMANCE_MIXER_HPP
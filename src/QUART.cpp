@@ -2,6 +2,7 @@
 #include "plugin.hpp"
 #include <componentlibrary.hpp>
 #include "NANOComponents.hpp"
+#include "NANOTiming.hpp"
 
 // Include custom envelope and shaper utilities for sound shaping.
 #include "Resources/SynthTools/envelope.hpp"
@@ -16,6 +17,8 @@ struct QUART : Module
 {
     // Array of envelope generators, one per channel.
     ADEnvelope ENV[CHANNELS];
+    // Shared curve table for the rise and fall knob mapping.
+    std::shared_ptr<const Shaper::CurveTable> timeCurves = TableRegistry::acquire<Shaper::CurveTable>(STEEPNESS);
 
     // Arrays for storing frequency adjustment values, one per channel for rise and fall.
     float riseFreq[CHANNELS];
@@ -76,8 +79,8 @@ struct QUART : Module
         // TO DO: Match QUART rise & fall times with the real one, also curve skew
         for (int i = 0; i < CHANNELS; i++){
             // Calculate rise and fall times based on the parameter settings and the shaping curve.
-            float riseTime = Shaper::shapeCurve(params[RISE + i].getValue(), 0.0001087f, 0.65f, 0.0f, STEEPNESS);
-            float fallTime = Shaper::shapeCurve(params[FALL + i].getValue(), 0.0001087f, 0.65f, 0.0f, STEEPNESS);
+            float riseTime = Shaper::shapeCurve(params[RISE + i].getValue(), 0.0001087f, 0.65f, 0.0f, *timeCurves);
+            float fallTime = Shaper::shapeCurve(params[FALL + i].getValue(), 0.0001087f, 0.65f, 0.0f, *timeCurves);
 
             // Read the switch position to adjust rise and fall times based on frequency division settings.
             float switchPosition = params[SW + i].getValue();
@@ -132,4 +135,4 @@ struct QUARTWidget : ModuleWidget
     }
 };
 
-Model *modelQUART = createModel<QUART, QUARTWidget>("QUART");
\ No newline at end of file
+Model *modelQUART = createModel<NANOTiming::Timed<QUART>, NANOTiming::TimedWidget<QUARTWidget>>("QUART");
\ No newline at end of file
@@ -0,0 +1,65 @@
+//
+//  blockMeter.hpp
+//
+//  Peak and RMS meter for up to four signals, one per float_4 lane. Per sample it only
+//  keeps a running max of |x| and a sum of squares. Once per BLOCK samples it turns them
+//  into the block RMS and a peak that is held for a while and then decays, which is the
+//  rate lights and meter CVs need.
+//
+
+#ifndef BlockMeter_hpp
+#define BlockMeter_hpp
+
+#include <cmath>
+
+#include "rack.hpp"
+
+struct BlockMeter {
+    static const int BLOCK = 256;
+
+    // Results of the last completed block
+    rack::simd::float_4 peak = 0.0f;
+    rack::simd::float_4 rms = 0.0f;
+
+    rack::simd::float_4 blockPeak = 0.0f;
+    rack::simd::float_4 blockSquares = 0.0f;
+    // Blocks left before the held peak starts to decay
+    rack::simd::float_4 holdLeft = 0.0f;
+    int position = 0;
+    float holdBlocks = 0.0f;
+    float decay = 1.0f;
+    // Seconds per block, the time step for smoothing the lights
+    float blockTime = 0.0f;
+
+    BlockMeter() {
+        setSampleRate(44100.0f);
+    }
+
+    // Peaks are held for holdTime seconds, then fall by decayDb per second
+    void setSampleRate(float sampleRate, float holdTime = 0.5f, float decayDb = 20.0f) {
+        blockTime = BLOCK / sampleRate;
+        holdBlocks = std::ceil(holdTime / blockTime);
+        decay = std::pow(10.0f, -decayDb / 20.0f * blockTime);
+    }
+
+    // Returns true when x completed a block and peak and rms hold new values
+    bool process(rack::simd::float_4 x) {
+        using namespace rack::simd;
+        blockPeak = fmax(blockPeak, abs(x));
+        blockSquares += x * x;
+        if (++position < BLOCK)
+            return false;
+        position = 0;
+
+        rms = sqrt(blockSquares * (1.0f / BLOCK));
+        float_4 rising = blockPeak >= peak;
+        holdLeft = ifelse(rising, float_4(holdBlocks), fmax(holdLeft - 1.0f, float_4(0.0f)));
+        peak = ifelse(rising, blockPeak, ifelse(holdLeft > 0.0f, peak, peak * decay));
+
+        blockPeak = 0.0f;
+        blockSquares = 0.0f;
+        return true;
+    }
+};
+
+#endif /* BlockMeter_hpp */
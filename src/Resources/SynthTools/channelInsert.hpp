@@ -0,0 +1,111 @@
+//
+//  channelInsert.hpp
+//
+//  CEQ's three band EQ and compressor as an insert. The filters and the compressor follow
+//  daisysp::Svf and daisysp::Compressor step by step, written as templates so one instance
+//  on rack::simd::float_4 processes four channels, one per lane. The logs and exponentials
+//  of the compressor come from fastMath.hpp.
+//
+
+#ifndef ChannelInsert_hpp
+#define ChannelInsert_hpp
+
+#include <cmath>
+
+#include "rack.hpp"
+#include "fastMath.hpp"
+
+// daisysp::Svf with its default resonance and drive, low and high outputs only
+template <typename T>
+struct InsertSvf {
+    float freq = 0.25f;
+    float damp = 0.0f;
+    float drive = 0.5f;
+    T low = 0.0f;
+    T band = 0.0f;
+    T outLow = 0.0f;
+    T outHigh = 0.0f;
+
+    // Same coefficients as Svf::SetFreq with a resonance of 0.5
+    void setFreq(float fc, float sampleRate) {
+        fc = std::fmin(std::fmax(fc, 1.0e-6f), sampleRate / 3.0f);
+        freq = 2.0f * std::sin((float)M_PI * std::fmin(0.25f, fc / (sampleRate * 2.0f)));
+        damp = std::fmin(2.0f * (1.0f - std::pow(0.5f, 0.25f)), std::fmin(2.0f, 2.0f / freq - freq * 0.5f));
+    }
+
+    // Two passes per sample, the outputs are their average
+    void process(T in) {
+        T notch = in - damp * band;
+        low = low + freq * band;
+        T high = notch - low;
+        band = freq * high + band - drive * band * band * band;
+        outLow = 0.5f * low;
+        outHigh = 0.5f * high;
+
+        notch = in - damp * band;
+        low = low + freq * band;
+        high = notch - low;
+        band = freq * high + band - drive * band * band * band;
+        outLow += 0.5f * low;
+        outHigh += 0.5f * high;
+    }
+};
+
+// daisysp::Compressor, with threshold, ratio and makeup given per lane on every sample
+template <typename T>
+struct InsertCompressor {
+    float atkSlo = 0.0f;
+    float atkSlo2 = 0.0f;
+    float relSlo = 0.0f;
+    T slope = 0.1f;
+    T gainRec = 0.1f;
+
+    void setTimes(float attack, float release, float sampleRate) {
+        atkSlo = std::exp(-1.0f / (attack * sampleRate));
+        atkSlo2 = std::exp(-2.0f / (attack * sampleRate));
+        relSlo = std::exp(-1.0f / (release * sampleRate));
+    }
+
+    // Threshold and makeup in dB
+    T process(T in, T threshold, T ratio, T makeup) {
+        using namespace rack::simd;
+        T ratioMul = (1.0f - atkSlo2) * (1.0f / ratio - 1.0f);
+        T inAbs = abs(in);
+        T slo = ifelse(slope > inAbs, T(relSlo), T(atkSlo));
+        slope = slope * slo + (1.0f - slo) * inAbs;
+        gainRec = atkSlo2 * gainRec + ratioMul * fmax(20.0f * FastMath::log10(slope) - threshold, T(0.0f));
+        return FastMath::pow10(0.05f * (gainRec + makeup)) * in;
+    }
+};
+
+// CEQ's signal chain: band split at 256.7 Hz and 2567 Hz on the input scaled by 1/4, the
+// bands summed with their gains, then the compressor on one amount knob
+template <typename T>
+struct ChannelInsert {
+    InsertSvf<T> lowSplit;
+    InsertSvf<T> highSplit;
+    InsertCompressor<T> compressor;
+
+    ChannelInsert() {
+        setSampleRate(44100.0f);
+    }
+
+    void setSampleRate(float sampleRate) {
+        lowSplit.setFreq(256.7f, sampleRate);
+        highSplit.setFreq(2567.0f, sampleRate);
+        compressor.setTimes(0.01f, 0.01f, sampleRate);
+    }
+
+    // Band gains in [0, 2], amount in [0, 1]
+    T process(T in, T lowGain, T midGain, T highGain, T amount) {
+        using namespace rack::simd;
+        T x = fmin(fmax(in * 0.25f, T(-4.0f)), T(4.0f));
+        lowSplit.process(x);
+        highSplit.process(x);
+        T mid = lowSplit.outHigh - highSplit.outHigh;
+        T mix = lowSplit.outLow * lowGain + mid * midGain + highSplit.outHigh * highGain;
+        return compressor.process(mix * 4.0f, amount * -10.0f, amount * 4.0f + 1.0f, amount * 14.0f);
+    }
+};
+
+#endif /* ChannelInsert_hpp */
@@ -0,0 +1,80 @@
+//
+//  clipper.hpp
+//
+//  Soft and hard clipping with first order antiderivative antialiasing. Each output is the
+//  clipping curve averaged over the straight line between the last two inputs,
+//  (F(x[n]) - F(x[n - 1])) / (x[n] - x[n - 1]) with F the antiderivative of the curve, so the
+//  harmonics the clipper adds are filtered before they are sampled instead of folding back.
+//  Costs half a sample of delay. Written for rack::simd::float_4, e.g. a stereo pair in the
+//  first two lanes.
+//
+
+#ifndef Clipper_hpp
+#define Clipper_hpp
+
+#include "rack.hpp"
+
+struct AdaaClipper {
+    // Curves of the normalized input v, both reach the level at |v| = 1
+    //   SOFT  v - v^3 / 3, scaled so small signals pass at unity gain
+    //   HARD  clamp(v, -1, 1)
+    enum Curves {
+        SOFT,
+        HARD
+    };
+
+    rack::simd::float_4 last = 0.0f;
+    rack::simd::float_4 lastIntegral = 0.0f;
+
+    static rack::simd::float_4 curve(rack::simd::float_4 v, int shape) {
+        using namespace rack::simd;
+        float_4 c = clamp(v, float_4(-1.0f), float_4(1.0f));
+        return shape == SOFT ? c - c * c * c * (1.0f / 3.0f) : c;
+    }
+
+    // Antiderivative, the knee part plus the straight part past |v| = 1
+    static rack::simd::float_4 integral(rack::simd::float_4 v, int shape) {
+        using namespace rack::simd;
+        float_4 a = abs(v);
+        float_4 c = fmin(a, float_4(1.0f));
+        float_4 c2 = c * c;
+        if (shape == SOFT)
+            return c2 * 0.5f - c2 * c2 * (1.0f / 12.0f) + (a - c) * (2.0f / 3.0f);
+        return c2 * 0.5f + (a - c);
+    }
+
+    // Restarts from x without a step, e.g. after the clipper was bypassed
+    void reset(rack::simd::float_4 x, float level, int shape) {
+        last = x * inputScale(level, shape);
+        lastIntegral = integral(last, shape);
+    }
+
+    static float inputScale(float level, int shape) {
+        // The soft curve tops out at 2 / 3, a 1.5 times wider knee keeps unity gain at 0
+        return shape == SOFT ? 1.0f / (1.5f * level) : 1.0f / level;
+    }
+
+    rack::simd::float_4 process(rack::simd::float_4 x, float level, int shape) {
+        using namespace rack::simd;
+        float_4 v = x * inputScale(level, shape);
+        float_4 F = integral(v, shape);
+        float_4 sum = v + last;
+
+        // The difference quotient cancels badly for close samples, where the curve allows
+        // it the quotient is taken in closed form
+        float_4 inside = fmax(abs(v), abs(last)) <= 1.0f;
+        float_4 knee = shape == SOFT ? sum * 0.5f * (1.0f - (v * v + last * last) * (1.0f / 6.0f)) : sum * 0.5f;
+        float_4 saturated = (v * last > 0.0f) & (fmin(abs(v), abs(last)) >= 1.0f);
+        float_4 d = v - last;
+        float_4 close = abs(d) < 1e-3f;
+        float_4 y = ifelse(close, curve(sum * 0.5f, shape), (F - lastIntegral) / ifelse(close, float_4(1.0f), d));
+        y = ifelse(saturated, curve(v, shape), y);
+        y = ifelse(inside, knee, y);
+
+        last = v;
+        lastIntegral = F;
+        return y * (shape == SOFT ? 1.5f * level : level);
+    }
+};
+
+#endif /* Clipper_hpp */
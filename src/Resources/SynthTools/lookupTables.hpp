@@ -0,0 +1,187 @@
+//
+//  lookupTables.hpp
+//
+//  Read-only tables for the per-sample transcendental functions.
+//  Instances are shared between modules through TableRegistry, see tableRegistry.hpp.
+//
+
+#ifndef LookupTables_hpp
+#define LookupTables_hpp
+
+#include <cmath>
+#include <string>
+
+#include "rack.hpp"
+
+// A function sampled with its slope at SIZE + 1 evenly spaced points and read back with
+// cubic Hermite interpolation. With exact slopes the error falls with the fourth power
+// of the spacing, so a few hundred points reach float precision on smooth curves.
+template <int SIZE>
+struct HermiteTable {
+    float value[SIZE + 1];
+    // Slopes premultiplied by the point spacing
+    float slope[SIZE + 1];
+    float xMin = 0.0f;
+    float scale = (float)SIZE;
+
+    // Samples f and its derivative df over [lo, hi], evaluated in double
+    template <typename F, typename DF>
+    void build(double lo, double hi, F f, DF df) {
+        double h = (hi - lo) / SIZE;
+        xMin = (float)lo;
+        scale = (float)(SIZE / (hi - lo));
+        for (int i = 0; i <= SIZE; i++) {
+            double x = lo + i * h;
+            value[i] = (float)f(x);
+            slope[i] = (float)(df(x) * h);
+        }
+    }
+
+    // Inputs outside the table range are clamped to it
+    float lookup(float x) const {
+        float position = (x - xMin) * scale;
+        position = position > 0.0f ? position : 0.0f;
+        position = position < (float)SIZE ? position : (float)SIZE;
+        int i = (int)position;
+        if (i >= SIZE) i = SIZE - 1;
+        float t = position - i;
+
+        float p0 = value[i];
+        float m0 = slope[i];
+        float m1 = slope[i + 1];
+        float d = value[i + 1] - p0;
+        float a = m0 + m1 - 2 * d;
+        float b = 3 * d - 2 * m0 - m1;
+        return ((a * t + b) * t + m0) * t + p0;
+    }
+};
+
+// The same curve for four inputs at once in rack::simd::float_4. Every segment keeps its
+// cubic as one row of four coefficients, so a lane costs a single vector load and a 4x4
+// transpose turns the rows into one vector per coefficient, no per element gathers.
+template <int SIZE>
+struct SimdHermiteTable {
+    // p0, m0, b, a of ((a * t + b) * t + m0) * t + p0, same arithmetic as HermiteTable
+    alignas(16) float segment[SIZE][4];
+    float xMin = 0.0f;
+    float scale = (float)SIZE;
+
+    template <typename F, typename DF>
+    void build(double lo, double hi, F f, DF df) {
+        HermiteTable<SIZE> points;
+        points.build(lo, hi, f, df);
+        xMin = points.xMin;
+        scale = points.scale;
+        for (int i = 0; i < SIZE; i++) {
+            float p0 = points.value[i];
+            float m0 = points.slope[i];
+            float m1 = points.slope[i + 1];
+            float d = points.value[i + 1] - p0;
+            segment[i][0] = p0;
+            segment[i][1] = m0;
+            segment[i][2] = 3 * d - 2 * m0 - m1;
+            segment[i][3] = m0 + m1 - 2 * d;
+        }
+    }
+
+    // Inputs outside the table range are clamped to it
+    rack::simd::float_4 lookup(rack::simd::float_4 x) const {
+        using namespace rack::simd;
+        float_4 position = clamp((x - xMin) * scale, float_4(0.0f), float_4((float)SIZE));
+        int32_4 index = int32_4(fmin(position, float_4((float)(SIZE - 1))));
+        float_4 t = position - float_4(index);
+
+        int32_t i[4];
+        index.store(i);
+        float_4 p0 = float_4::load(segment[i[0]]);
+        float_4 m0 = float_4::load(segment[i[1]]);
+        float_4 b = float_4::load(segment[i[2]]);
+        float_4 a = float_4::load(segment[i[3]]);
+        _MM_TRANSPOSE4_PS(p0.v, m0.v, b.v, a.v);
+        return ((a * t + b) * t + m0) * t + p0;
+    }
+};
+
+// Pan laws by their attenuation at the centre, the right gain is the left one mirrored,
+// gain(1 - pan) for pan in [0, 1].
+//   -3 dB    equal power, cos(pan * pi / 2)
+//   -4.5 dB  the geometric mean of the -3 and -6 dB laws
+//   -6 dB    equal voltage, 1 - pan
+//   0 dB     balance, full level up to the centre, then linear down to 0
+// Only the two curved laws need tables, the straight ones are cheaper to compute.
+struct PanLawTable {
+    enum Laws {
+        LAW_3DB,
+        LAW_4_5DB,
+        LAW_6DB,
+        LAW_BALANCE,
+        NUM_LAWS
+    };
+
+    SimdHermiteTable<256> equalPower;
+    SimdHermiteTable<256> compromise;
+
+    PanLawTable() {
+        equalPower.build(0.0, 1.0,
+                         [](double p) { return std::cos(p * M_PI_2); },
+                         [](double p) { return -std::sin(p * M_PI_2) * M_PI_2; });
+        // sqrt((1 - p) * cos(p * pi / 2)), which tends to sqrt(pi / 2) * (1 - p) at the right end
+        compromise.build(0.0, 1.0,
+                         [](double p) { return std::sqrt((1.0 - p) * std::cos(p * M_PI_2)); },
+                         [](double p) {
+                             double g = (1.0 - p) * std::cos(p * M_PI_2);
+                             if (g <= 0.0)
+                                 return -std::sqrt(M_PI_2);
+                             double dg = -std::cos(p * M_PI_2) - (1.0 - p) * std::sin(p * M_PI_2) * M_PI_2;
+                             return dg / (2.0 * std::sqrt(g));
+                         });
+    }
+
+    static std::string registryKey() {
+        return "panlaw";
+    }
+
+    // Left and right gains of four pans
+    void gains(int law, rack::simd::float_4 pan, rack::simd::float_4 &left, rack::simd::float_4 &right) const {
+        using namespace rack::simd;
+        switch (law) {
+            case LAW_4_5DB:
+                left = compromise.lookup(pan);
+                right = compromise.lookup(1.0f - pan);
+                break;
+            case LAW_6DB:
+                left = 1.0f - pan;
+                right = pan;
+                break;
+            case LAW_BALANCE:
+                left = fmin(2.0f - 2.0f * pan, float_4(1.0f));
+                right = fmin(2.0f * pan, float_4(1.0f));
+                break;
+            default:
+                left = equalPower.lookup(pan);
+                right = equalPower.lookup(1.0f - pan);
+                break;
+        }
+    }
+};
+
+// tanh waveshaper. Inputs beyond +-10 saturate, tanh(10) is 1 in float anyway.
+struct TanhTable {
+    HermiteTable<1024> curve;
+
+    TanhTable() {
+        curve.build(-10.0, 10.0,
+                    [](double x) { return std::tanh(x); },
+                    [](double x) { return 1.0 - std::tanh(x) * std::tanh(x); });
+    }
+
+    static std::string registryKey() {
+        return "waveshaper/tanh";
+    }
+
+    float tanh(float x) const {
+        return curve.lookup(x);
+    }
+};
+
+#endif /* LookupTables_hpp */
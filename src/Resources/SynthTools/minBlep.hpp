@@ -0,0 +1,94 @@
+//
+//  minBlep.hpp
+//
+//  Minimum-phase band-limited steps for float_4 signals, like rack::dsp::MinBlepGenerator
+//  but with the impulse shared between every generator through TableRegistry instead of a
+//  copy per generator. A module with a generator per output and voice group keeps one
+//  impulse in cache instead of dozens.
+//
+//  The impulse is stored by sub-sample position, so the residual of a step is two contiguous
+//  rows blended, and every lane keeps its residuals in a straight buffer that is shifted down
+//  once per 2 * Z samples instead of a ring indexed modulo 2 * Z.
+//
+
+#ifndef MinBlep_hpp
+#define MinBlep_hpp
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "rack.hpp"
+#include "tableRegistry.hpp"
+
+// Integral of a windowed sinc of Z zero crossings sampled O times per crossing, minus the step
+// it smooths. Row k holds the residuals of a step k / O of a sample before the frame, one per
+// frame, row O closes the last interval.
+template <int Z, int O>
+struct MinBlepTable {
+    float residual[O + 1][2 * Z];
+
+    MinBlepTable() {
+        float impulse[2 * Z * O + 1];
+        rack::dsp::minBlepImpulse(Z, O, impulse);
+        impulse[2 * Z * O] = 1.0f;
+        for (int k = 0; k <= O; k++) {
+            for (int j = 0; j < 2 * Z; j++)
+                residual[k][j] = impulse[j * O + k] - 1.0f;
+        }
+    }
+
+    static std::string registryKey() {
+        return "minblep/" + std::to_string(Z) + "x" + std::to_string(O);
+    }
+};
+
+template <int Z, int O>
+struct SharedMinBlep {
+    // Residuals still to play per lane, the frame to play next at pos
+    float buf[4][4 * Z];
+    int pos = 0;
+    std::shared_ptr<const MinBlepTable<Z, O>> mTable = TableRegistry::acquire<MinBlepTable<Z, O>>();
+
+    SharedMinBlep() {
+        reset();
+    }
+
+    void reset() {
+        std::memset(buf, 0, sizeof(buf));
+        pos = 0;
+    }
+
+    // Places the step x of every lane at -1 < p <= 0 relative to the current frame, lanes with p
+    // outside that range or no step are skipped
+    void insertDiscontinuity(rack::simd::float_4 p, rack::simd::float_4 x) {
+        for (int i = 0; i < 4; i++) {
+            if (!(-1.0f < p[i] && p[i] <= 0.0f) || x[i] == 0.0f)
+                continue;
+            float position = -p[i] * O;
+            // A step just after the previous frame can round up to the last row
+            int k = std::min((int)position, O - 1);
+            float t = position - k;
+            const float *a = mTable->residual[k];
+            const float *b = mTable->residual[k + 1];
+            float *lane = buf[i] + pos;
+            for (int j = 0; j < 2 * Z; j++)
+                lane[j] += x[i] * (a[j] + (b[j] - a[j]) * t);
+        }
+    }
+
+    rack::simd::float_4 process() {
+        rack::simd::float_4 v(buf[0][pos], buf[1][pos], buf[2][pos], buf[3][pos]);
+        if (++pos == 2 * Z) {
+            for (int i = 0; i < 4; i++) {
+                std::memcpy(buf[i], buf[i] + 2 * Z, 2 * Z * sizeof(float));
+                std::memset(buf[i] + 2 * Z, 0, 2 * Z * sizeof(float));
+            }
+            pos = 0;
+        }
+        return v;
+    }
+};
+
+#endif /* MinBlep_hpp */
@@ -0,0 +1,69 @@
+//
+//  pitchTable.hpp
+//
+//  V/Oct pitch to frequency ratio. The whole octaves of 2^pitch go straight into the float
+//  exponent and the whole cents are read from one octave sampled every cent. What is left
+//  is under a cent, where 2^f = 1 + u + u^2 / 2 with u = f * ln(2) is off by u^3 / 6, below
+//  3.3e-11 relative. Linear interpolation between the points would be off by 4.2e-8, which a
+//  free running oscillator adds up into an audible phase drift within seconds.
+//  The same table serves any volts per octave, e.g. ONA's LFO scale of 3^pitch is
+//  2^(pitch * log2(3)).
+//  Shared between modules through TableRegistry, see tableRegistry.hpp.
+//
+
+#ifndef PitchTable_hpp
+#define PitchTable_hpp
+
+#include <cmath>
+#include <stdint.h>
+#include <string>
+
+#include "rack.hpp"
+#include "fastMath.hpp"
+
+struct PitchTable {
+    static const int CENTS = 1200;
+    // ln(2) per cent
+    static constexpr float CENT_LOG = 5.7762265e-4f;
+
+    // 2^(c / 1200) for c in [0, 1200)
+    float octave[CENTS];
+
+    PitchTable() {
+        for (int c = 0; c < CENTS; c++)
+            octave[c] = (float)std::exp2(c / (double)CENTS);
+    }
+
+    static std::string registryKey() {
+        return "pitch/cents";
+    }
+
+    // 2^pitch, pitch clamped to the normal float exponents
+    float exp2(float pitch) const {
+        pitch = std::fmin(std::fmax(pitch, -126.0f), 126.0f);
+        float n = std::floor(pitch);
+        float position = (pitch - n) * (float)CENTS;
+        int c = std::min((int)position, CENTS - 1);
+        float u = (position - c) * CENT_LOG;
+        float ratio = octave[c] * (1.0f + u * (1.0f + 0.5f * u));
+        return ratio * FastMath::exponentScale(n);
+    }
+
+    rack::simd::float_4 exp2(rack::simd::float_4 pitch) const {
+        using namespace rack::simd;
+        pitch = fmin(fmax(pitch, float_4(-126.0f)), float_4(126.0f));
+        float_4 n = floor(pitch);
+        float_4 position = (pitch - n) * (float)CENTS;
+        int32_4 c = int32_4(fmin(position, float_4((float)(CENTS - 1))));
+        float_4 u = (position - float_4(c)) * CENT_LOG;
+        // The only per lane work is the load itself
+        int32_t cents[4];
+        c.store(cents);
+        float ratio[4];
+        for (int i = 0; i < 4; i++)
+            ratio[i] = octave[cents[i]];
+        return float_4::load(ratio) * (1.0f + u * (1.0f + 0.5f * u)) * FastMath::exponentScale(n);
+    }
+};
+
+#endif /* PitchTable_hpp */
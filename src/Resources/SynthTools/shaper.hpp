@@ -2,9 +2,59 @@
 #define SHAPER_HPP
 
 #include <cmath> // For powf and log10
+#include <cstdio>
+#include <string>
+
+#include "lookupTables.hpp"
 
 class Shaper {
 public:
+    // Exponential and logarithmic curves for one steepness, plus their inverses, so the
+    // per-sample shaping needs no exp or log. Shape only blends these curves with the
+    // identity, so one table serves every shape. Shared between modules through
+    // TableRegistry, keyed by steepness.
+    struct CurveTable {
+        enum Curve {
+            EXP_CURVE,
+            LOG_CURVE,
+            EXP_INVERSE,
+            LOG_INVERSE,
+            NUM_CURVES
+        };
+
+        float steepnessAdjustment;
+        HermiteTable<256> curves[NUM_CURVES];
+
+        explicit CurveTable(float steepnessAdjustment) : steepnessAdjustment(steepnessAdjustment) {
+            double k = 1 + steepnessAdjustment * 9; // Same k as the analytic path
+            double expMax = std::exp(k) - 1;
+            double logMax = std::log(k + 1);
+
+            curves[EXP_CURVE].build(0.0, 1.0,
+                                    [=](double x) { return (std::exp(k * x) - 1) / expMax; },
+                                    [=](double x) { return k * std::exp(k * x) / expMax; });
+            curves[LOG_CURVE].build(0.0, 1.0,
+                                    [=](double x) { return std::log(k * x + 1) / logMax; },
+                                    [=](double x) { return k / ((k * x + 1) * logMax); });
+            curves[EXP_INVERSE].build(0.0, 1.0,
+                                      [=](double y) { return std::log(y * expMax + 1) / k; },
+                                      [=](double y) { return expMax / (k * (y * expMax + 1)); });
+            curves[LOG_INVERSE].build(0.0, 1.0,
+                                      [=](double y) { return (std::exp(y * logMax) - 1) / k; },
+                                      [=](double y) { return logMax * std::exp(y * logMax) / k; });
+        }
+
+        static std::string registryKey(float steepnessAdjustment) {
+            char key[32];
+            snprintf(key, sizeof(key), "shaper/%.6g", steepnessAdjustment);
+            return key;
+        }
+
+        float lookup(Curve curve, float x) const {
+            return curves[curve].lookup(x);
+        }
+    };
+
     // Helper function to linearly interpolate between two values
     static float interpolate(float a, float b, float t) {
         return a * (1 - t) + b * t;
@@ -73,6 +123,40 @@ public:
             return outputLevel;
         }
     }
+
+    // Table driven shapeCurve, phases outside [0, 1] fall back to the analytic curve
+    static float shapeCurve(float currentPhase, float minValue, float maxValue, float shape, const CurveTable& curves) {
+        if (!(currentPhase >= 0.0f && currentPhase <= 1.0f)) {
+            return shapeCurve(currentPhase, minValue, maxValue, shape, curves.steepnessAdjustment);
+        }
+
+        if (shape < 0.5f) {
+            float expOutput = curves.lookup(CurveTable::EXP_CURVE, currentPhase);
+            return adjustRange(interpolate(expOutput, currentPhase, shape * 2), minValue, maxValue);
+        } else if (shape > 0.5f) {
+            float logOutput = curves.lookup(CurveTable::LOG_CURVE, currentPhase);
+            return adjustRange(interpolate(currentPhase, logOutput, (shape - 0.5f) * 2), minValue, maxValue);
+        } else {
+            return adjustRange(currentPhase, minValue, maxValue);
+        }
+    }
+
+    // Table driven inverseShapePhase, levels outside [0, 1] fall back to the analytic inverse
+    static float inverseShapePhase(float outputLevel, float shape, const CurveTable& curves) {
+        if (!(outputLevel >= 0.0f && outputLevel <= 1.0f)) {
+            return inverseShapePhase(outputLevel, shape, curves.steepnessAdjustment);
+        }
+
+        if (shape < 0.5f) {
+            float expOutput = curves.lookup(CurveTable::EXP_INVERSE, outputLevel);
+            return interpolate(expOutput, outputLevel, shape * 2);
+        } else if (shape > 0.5f) {
+            float logOutput = curves.lookup(CurveTable::LOG_INVERSE, outputLevel);
+            return interpolate(outputLevel, logOutput, (shape - 0.5f) * 2);
+        } else {
+            return outputLevel;
+        }
+    }
 };
 
 #endif // SHAPER_HPP
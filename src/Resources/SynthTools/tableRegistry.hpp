@@ -0,0 +1,53 @@
+//
+//  tableRegistry.hpp
+//
+//  Process wide registry of read-only lookup tables.
+//  A table is built the first time a module asks for it and shared by every instance after
+//  that, on every engine thread. Modules keep the returned shared_ptr as a member, so the
+//  table lives as long as at least one module uses it and nothing is built before a module
+//  that needs it is placed.
+//
+//  Acquire tables when the module is constructed, never from process(). The audio thread
+//  only reads through the pointer it already holds.
+//
+
+#ifndef TableRegistry_hpp
+#define TableRegistry_hpp
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+class TableRegistry {
+public:
+    // Returns the shared table for the given build arguments, building it if no module holds it.
+    // TTable must be constructible from args and provide static std::string registryKey(args).
+    template <class TTable, class... Args>
+    static std::shared_ptr<const TTable> acquire(Args... args) {
+        std::string key = TTable::registryKey(args...);
+
+        std::lock_guard<std::mutex> lock(mutex());
+        std::weak_ptr<const void>& slot = tables()[key];
+        std::shared_ptr<const void> table = slot.lock();
+        if (!table) {
+            table = std::make_shared<const TTable>(args...);
+            slot = table;
+        }
+        return std::static_pointer_cast<const TTable>(table);
+    }
+
+private:
+    static std::mutex& mutex() {
+        static std::mutex m;
+        return m;
+    }
+
+    // Weak references only, the last module holding a table frees it
+    static std::map<std::string, std::weak_ptr<const void>>& tables() {
+        static std::map<std::string, std::weak_ptr<const void>> t;
+        return t;
+    }
+};
+
+#endif /* TableRegistry_hpp */
@@ -0,0 +1,104 @@
+//
+//  wavetables.hpp
+//
+//  Band-limited single cycle waveforms, one table per octave of fundamental frequency.
+//  Level L holds the harmonics up to (SIZE / 2) >> L, so a read through the level picked
+//  for the phase increment never holds partials above Nyquist. Built once in double and
+//  shared between modules through TableRegistry, see tableRegistry.hpp.
+//
+
+#ifndef Wavetables_hpp
+#define Wavetables_hpp
+
+#include <cmath>
+#include <stdint.h>
+#include <string>
+
+#include "rack.hpp"
+#include "fastMath.hpp"
+
+struct MipmapWavetables {
+    static const int SIZE = 2048;
+    static const int LEVELS = 11;
+
+    enum Waves {
+        SAW,
+        TRIANGLE,
+        SQUARE,
+        NUM_WAVES
+    };
+
+    // One guard point past the end of every table so the interpolation never wraps
+    float tables[NUM_WAVES][LEVELS][SIZE + 1];
+
+    // Additive synthesis of the rising saw 2T - 1, the triangle that starts at -1 and the square
+    // that is high for the first half cycle.
+    // Level L is the partial sum of the series up to harmonic (SIZE / 2) >> L, the harmonics
+    // are stepped with a rotation so the whole set costs one pass over the series.
+    MipmapWavetables() {
+        for (int n = 0; n < SIZE; n++) {
+            double theta = 2.0 * M_PI * n / SIZE;
+            double cosTheta = std::cos(theta);
+            double sinTheta = std::sin(theta);
+            double c = 1.0, s = 0.0;
+            double saw = 0.0, triangle = 0.0, square = 0.0;
+            int level = LEVELS - 1;
+            for (int k = 1; level >= 0; k++) {
+                double ck = c * cosTheta - s * sinTheta;
+                s = s * cosTheta + c * sinTheta;
+                c = ck;
+                saw += s / k;
+                if (k & 1) {
+                    triangle += c / ((double)k * k);
+                    square += s / k;
+                }
+                if (k == (SIZE / 2) >> level) {
+                    tables[SAW][level][n] = (float)(-2.0 / M_PI * saw);
+                    tables[TRIANGLE][level][n] = (float)(-8.0 / (M_PI * M_PI) * triangle);
+                    tables[SQUARE][level][n] = (float)(4.0 / M_PI * square);
+                    level--;
+                }
+            }
+        }
+        for (int w = 0; w < NUM_WAVES; w++) {
+            for (int l = 0; l < LEVELS; l++)
+                tables[w][l][SIZE] = tables[w][l][0];
+        }
+    }
+
+    static std::string registryKey() {
+        return "wavetable/mipmap";
+    }
+
+    // Table level for a phase increment dt in cycles per sample: the lowest level whose top
+    // harmonic stays below Nyquist, ((SIZE / 2) >> L) * dt <= 0.5, so L = 11 + ceil(log2(dt)).
+    // An octave lower is one level lower.
+    static rack::simd::float_4 level(rack::simd::float_4 dt) {
+        using namespace rack::simd;
+        float_4 mantissa;
+        float_4 l = 11.0f + FastMath::splitExponent(dt, mantissa);
+        l += ifelse(mantissa > 1.0f, 1.0f, 0.0f);
+        return clamp(l, float_4(0.0f), float_4((float)(LEVELS - 1)));
+    }
+
+    // Linearly interpolated read of 4 phases T in [0, 1), each lane from its own level
+    rack::simd::float_4 read(int wave, rack::simd::float_4 level, rack::simd::float_4 T) const {
+        using namespace rack::simd;
+        float_4 position = clamp(T * (float)SIZE, float_4(0.0f), float_4((float)SIZE));
+        float_4 index = fmin(floor(position), float_4((float)(SIZE - 1)));
+        float_4 t = position - index;
+        // Offsets from the first level, the only per lane work left is the load itself
+        int32_t offsets[4];
+        int32_4(level * (float)(SIZE + 1) + index).store(offsets);
+        const float *base = tables[wave][0];
+        float a[4], b[4];
+        for (int i = 0; i < 4; i++) {
+            a[i] = base[offsets[i]];
+            b[i] = base[offsets[i] + 1];
+        }
+        float_4 a4 = float_4::load(a);
+        return a4 + (float_4::load(b) - a4) * t;
+    }
+};
+
+#endif /* Wavetables_hpp */
@@ -2,6 +2,7 @@
 #include "plugin.hpp"
 #include <componentlibrary.hpp>
 #include "NANOComponents.hpp"
+#include "NANOTiming.hpp"
 
 // Include resources for additional envelope and shaping functionalities.
 #include "Resources/SynthTools/envelope.hpp"
@@ -69,6 +70,8 @@ struct SERRA : Module
 
     // ADSR envelope generator object.
     ADSREnvelope ENV;
+    // Shared curve table for the time knob mapping.
+    std::shared_ptr<const Shaper::CurveTable> timeCurves = TableRegistry::acquire<Shaper::CurveTable>(STEEPNESS);
 
     // Constructor for initializing module parameters and envelope generator.
     SERRA()
@@ -143,9 +146,9 @@ struct SERRA : Module
         sustain = inputs[S_CV_INPUT].getVoltage();
 
         // Calculate time constants for each stage using shaped curves.
-        float attackFactor   = Shaper::shapeCurve(params[ATTACK_PARAM ].getValue() + attack  / CV_GAIN, MIN, FAST, 0.0f, STEEPNESS);
-        float decayFactor    = Shaper::shapeCurve(params[DECAY_PARAM  ].getValue() + decay   / CV_GAIN, MIN, SLOW, 0.0f, STEEPNESS);
-        float releaseFactor  = Shaper::shapeCurve(params[RELEASE_PARAM].getValue() + release / CV_GAIN, MIN, SLOW, 0.0f, STEEPNESS);
+        float attackFactor   = Shaper::shapeCurve(params[ATTACK_PARAM ].getValue() + attack  / CV_GAIN, MIN, FAST, 0.0f, *timeCurves);
+        float decayFactor    = Shaper::shapeCurve(params[DECAY_PARAM  ].getValue() + decay   / CV_GAIN, MIN, SLOW, 0.0f, *timeCurves);
+        float releaseFactor  = Shaper::shapeCurve(params[RELEASE_PARAM].getValue() + release / CV_GAIN, MIN, SLOW, 0.0f, *timeCurves);
         float sustainFactor  = params[SUSTAIN_PARAM].getValue() + sustain / CV_GAIN;
 
         // Apply calculated factors to the envelope generator.
@@ -232,4 +235,4 @@ struct SERRAWidget : ModuleWidget
     }
 };
 
-Model *modelSERRA = createModel<SERRA, SERRAWidget>("SERRA");
\ No newline at end of file
+Model *modelSERRA = createModel<NANOTiming::Timed<SERRA>, NANOTiming::TimedWidget<SERRAWidget>>("SERRA");
\ No newline at end of file
@@ -1,8 +1,8 @@
 #include "plugin.hpp"
 #include <componentlibrary.hpp>
 #include "NANOComponents.hpp"
-
-#define LED_SMOOTHING 0.00005f
+#include "NANOTiming.hpp"
+#include "Resources/SynthTools/blockMeter.hpp"
 
 struct STMAR : Module
 {   
@@ -11,6 +11,9 @@ struct STMAR : Module
     float l3_input, r3_input;
     float cv1_input, cv2_input, cv3_input;
 
+    // The mix before the master gain, L and R in the first two lanes
+    BlockMeter meter;
+
     enum ParamIds
     {
         POT1_PARAM,
@@ -39,6 +42,7 @@ struct STMAR : Module
     {
         L_OUTPUT,
         R_OUTPUT,
+        METER_OUTPUT,
         NUM_OUTPUTS
     };
     enum LightIds {
@@ -77,6 +81,11 @@ struct STMAR : Module
 
         configOutput(L_OUTPUT, "L");
         configOutput(R_OUTPUT, "R");
+        configOutput(METER_OUTPUT, "Meter, RMS of L and R");
+    }
+
+    void onSampleRateChange(const SampleRateChangeEvent &e) override {
+        meter.setSampleRate(e.sampleRate);
     }
 
     void process(const ProcessArgs &args) override
@@ -142,23 +151,21 @@ struct STMAR : Module
         outputs[L_OUTPUT].setVoltage(out_l);
         outputs[R_OUTPUT].setVoltage(out_r);
 
-        // Set the LEDs brightness depending on output signal
-        lights[L_LIGHT].setSmoothBrightness(mix_l / 5.0, LED_SMOOTHING);
-        lights[R_LIGHT].setSmoothBrightness(mix_r / 5.0, LED_SMOOTHING);
-
-        // Use a comparator for the clip leds
-        if(abs(mix_l) > 10.0f){
-            lights[CLIPL_LIGHT].setSmoothBrightness(1.0f, LED_SMOOTHING);
-        } else {
-            lights[CLIPL_LIGHT].setSmoothBrightness(0.0f, LED_SMOOTHING);
+        // Meter every sample, the lights and the meter CV only change once per block
+        if (meter.process(simd::float_4(mix_l, mix_r, 0.0f, 0.0f))) {
+            // Set the LEDs brightness depending on output signal
+            lights[L_LIGHT].setBrightnessSmooth(meter.rms[0] / 5.0f, meter.blockTime);
+            lights[R_LIGHT].setBrightnessSmooth(meter.rms[1] / 5.0f, meter.blockTime);
+            // The clip LEDs follow the held peak, so a single clipped sample stays visible
+            lights[CLIPL_LIGHT].setBrightness(meter.peak[0] > 10.0f);
+            lights[CLIPR_LIGHT].setBrightness(meter.peak[1] > 10.0f);
+
+            if (outputs[METER_OUTPUT].isConnected()) {
+                outputs[METER_OUTPUT].setChannels(2);
+                outputs[METER_OUTPUT].setVoltage(meter.rms[0], 0);
+                outputs[METER_OUTPUT].setVoltage(meter.rms[1], 1);
+            }
         }
-
-        if(abs(mix_r) > 10.0f){
-            lights[CLIPR_LIGHT].setSmoothBrightness(1.0f, LED_SMOOTHING);
-        } else {
-            lights[CLIPR_LIGHT].setSmoothBrightness(0.0f, LED_SMOOTHING);
-        }
-
     }
 };
 
@@ -177,7 +184,7 @@ struct STMARWidget : ModuleWidget
         addParam(createParamCentered<Davies1900hWhiteKnob>(mm2px(Vec(30.0, 20.25)), module, STMAR::POT1_PARAM));
         addParam(createParamCentered<Davies1900hWhiteKnob>(mm2px(Vec(30.0, 47.75)), module, STMAR::POT2_PARAM));
         addParam(createParamCentered<Davies1900hWhiteKnob>(mm2px(Vec(30.0, 75.40)), module, STMAR::POT3_PARAM));
-        addParam(createParamCentered<Davies1900hBlackKnob>(mm2px(Vec(30.0, 103.0)), module, STMAR::POTM_PARAM));
+        addParam(createParamCentered<Davies1900hBlackKnob>(mm2px(Vec(30.0, 101.5)), module, STMAR::POTM_PARAM));
 
         addInput(createInputCentered<PJ301MPort>(mm2px(Vec(5,  14.50)), module, STMAR::L1_INPUT));
         addInput(createInputCentered<PJ301MPort>(mm2px(Vec(15, 14.50)), module, STMAR::R1_INPUT));
@@ -197,6 +204,7 @@ struct STMARWidget : ModuleWidget
 
         addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(5, 108.25)), module, STMAR::L_OUTPUT));
         addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(15, 108.25)), module, STMAR::R_OUTPUT));
+        addOutput(createOutputCentered<PJ301MPort>(mm2px(Vec(34.5, 116.0)), module, STMAR::METER_OUTPUT));
 
         addChild(createLightCentered<MediumLight<WhiteLight>>(mm2px(Vec(4.00, 99.5)), module, STMAR::L_LIGHT));
         addChild(createLightCentered<MediumLight<WhiteLight>>(mm2px(Vec(16.0, 99.5)), module, STMAR::R_LIGHT));
@@ -205,4 +213,4 @@ struct STMARWidget : ModuleWidget
     }
 };
 
-Model *modelSTMAR = createModel<STMAR, STMARWidget>("STMAR");
\ No newline at end of file
+Model *modelSTMAR = createModel<NANOTiming::Timed<STMAR>, NANOTiming::TimedWidget<STMARWidget>>("STMAR");
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "plugin.hpp"
 #include <componentlibrary.hpp>
 #include "NANOComponents.hpp"
+#include "NANOTiming.hpp"
 
 #include "Resources/SynthTools/randomVoltage.hpp"
 
@@ -295,4 +296,4 @@ struct VCVRANDOMWidget : ModuleWidget
     }
 };
 
-Model *modelVCVRANDOM = createModel<VCVRANDOM, VCVRANDOMWidget>("VCVRANDOM");
\ No newline at end of file
+Model *modelVCVRANDOM = createModel<NANOTiming::Timed<VCVRANDOM>, NANOTiming::TimedWidget<VCVRANDOMWidget>>("VCVRANDOM");
\ No newline at end of file